@@ -14,8 +14,12 @@
 
 #include "BinaryIO.hpp"
 #include "Environment.hpp"
+#include "Pool.hpp"
 #include "Serial.hpp"
 
+#include <cstring>
+#include <type_traits>
+
 
 //----------------------------------------------------------------------------|
 // Static Functions                                                           |
@@ -23,10 +27,21 @@
 
 namespace ACSVM
 {
+   //
+   // AllocData
+   //
+   template<typename T>
+   static T *AllocData(Pool *pool)
+   {
+      if(!pool) return new T[1]{};
+
+      return static_cast<T *>(pool->allocZero(sizeof(T)));
+   }
+
    //
    // FreeData (Word)
    //
-   static void FreeData(Word &)
+   static void FreeData(Word &, Pool *)
    {
    }
 
@@ -34,14 +49,24 @@ namespace ACSVM
    // FreeData
    //
    template<typename T>
-   static void FreeData(T *&data)
+   static void FreeData(T *&data, Pool *pool)
    {
       if(!data) return;
 
       for(auto &itr : *data)
-         FreeData(itr);
+         FreeData(itr, pool);
+
+      if(pool)
+      {
+         // Blocks go back zeroed. Freeing the children above already nulled
+         // every pointer, so only pages of Words still need it.
+         if(std::is_same<typename std::remove_extent<T>::type, Word>::value)
+            std::memset(data, 0, sizeof(T));
 
-      delete[] data;
+         pool->free(data, sizeof(T));
+      }
+      else
+         delete[] data;
       data = nullptr;
    }
 
@@ -99,16 +124,16 @@ namespace ACSVM
    //
    Word &Array::operator [] (Word idx)
    {
-      if(!data) data = new Data[1]{};
+      if(!data) data = AllocData<Data>(pool);
       Bank *&bank = (*data)[idx / (BankSize * SegmSize * PageSize)];
 
-      if(!bank) bank = new Bank[1]{};
+      if(!bank) bank = AllocData<Bank>(pool);
       Segm *&segm = (*bank)[idx / (SegmSize * PageSize) % BankSize];
 
-      if(!segm) segm = new Segm[1]{};
+      if(!segm) segm = AllocData<Segm>(pool);
       Page *&page = (*segm)[idx / PageSize % SegmSize];
 
-      if(!page) page = new Page[1]{};
+      if(!page) page = AllocData<Page>(pool);
       return (*page)[idx % PageSize];
    }
 
@@ -135,7 +160,7 @@ namespace ACSVM
    //
    void Array::clear()
    {
-      FreeData(data);
+      FreeData(data, pool);
    }
 
    //
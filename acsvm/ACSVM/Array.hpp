@@ -27,12 +27,16 @@ namespace ACSVM
    //
    // Sparse-allocation array of 2**32 Words.
    //
+   // If given a Pool, takes its blocks from there and gives them back when
+   // cleared. Used for thread-local arrays, which come and go with threads.
+   //
    class Array
    {
    public:
-      Array() : data{nullptr} {}
+      Array() : data{nullptr}, pool{nullptr} {}
+      explicit Array(Pool *pool_) : data{nullptr}, pool{pool_} {}
       Array(Array const &) = delete;
-      Array(Array &&array) : data{array.data} {array.data = nullptr;}
+      Array(Array &&array) : data{array.data}, pool{array.pool} {array.data = nullptr;}
       ~Array() {clear();}
 
       Word &operator [] (Word idx);
@@ -66,6 +70,7 @@ namespace ACSVM
       using Data = Bank*[DataSize];
 
       Data *data;
+      Pool *pool;
    };
 }
 
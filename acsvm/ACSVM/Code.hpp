@@ -84,6 +84,7 @@ namespace ACSVM
       UnknownCode,
       UnknownFunc,
       BranchLimit,
+      FuseMismatch,
    };
 }
 
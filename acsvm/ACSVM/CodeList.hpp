@@ -126,6 +126,27 @@ ACSVM_CodeList(InvU,         0)
 ACSVM_CodeList(NegI,         0)
 ACSVM_CodeList(NotU,         0)
 
+// Fused codes. Module::fuseCode writes these over the first code of a common
+// sequence and leaves the rest of it in place, so they read their operands
+// from the original sequence and skip to its end.
+ACSVM_CodeList(Fuse_Drop_LocReg_Lit,    3) // Push_Lit, Drop_LocReg
+ACSVM_CodeList(Fuse_Push_LocReg_Lit,    3) // Push_LocReg, Push_Lit
+ACSVM_CodeList(Fuse_Push_LocReg_LocReg, 3) // Push_LocReg, Push_LocReg
+#define ACSVM_CodeList_FuseOpSet(name) \
+   ACSVM_CodeList(Fuse_##name##_LocLit, 6) \
+   ACSVM_CodeList(Fuse_##name##_LocLoc, 6)
+// Push_LocReg, Push_Lit or Push_LocReg, op, Drop_LocReg
+ACSVM_CodeList_FuseOpSet(Drop_AddU)
+ACSVM_CodeList_FuseOpSet(Drop_SubU)
+// Push_LocReg, Push_Lit or Push_LocReg, op, Jcnd_Nil
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpI_GE)
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpI_GT)
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpI_LE)
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpI_LT)
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpU_EQ)
+ACSVM_CodeList_FuseOpSet(Jcnd_CmpU_NE)
+#undef ACSVM_CodeList_FuseOpSet
+
 #undef ACSVM_CodeList
 #endif
 
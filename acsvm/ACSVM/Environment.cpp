@@ -112,7 +112,12 @@ namespace ACSVM
    Environment::Environment() :
       branchLimit  {0},
       scriptLocRegC{ScriptLocRegCDefault},
+      threadAllocC   {0},
+      threadAllocNewC{0},
       longDelay{false},
+      codeFuse     {true},
+      codeFuseCheck{false},
+      codeProfile  {false},
 
       funcV{nullptr},
       funcC{0},
@@ -355,6 +360,8 @@ namespace ACSVM
    //
    void Environment::freeThread(Thread *thread)
    {
+      thread->schedLink.unlink();
+      thread->sched = ThreadSched::None;
       thread->link.relink(&threadFree);
    }
 
@@ -381,6 +388,8 @@ namespace ACSVM
    //
    Thread *Environment::getFreeThread()
    {
+      ++threadAllocC;
+
       if(threadFree.next->obj)
       {
          Thread *thread = threadFree.next->obj;
@@ -388,7 +397,10 @@ namespace ACSVM
          return thread;
       }
       else
+      {
+         ++threadAllocNewC;
          return allocThread();
+      }
    }
 
    //
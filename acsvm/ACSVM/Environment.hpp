@@ -14,6 +14,7 @@
 #define ACSVM__Environment_H__
 
 #include "List.hpp"
+#include "Pool.hpp"
 #include "String.hpp"
 
 
@@ -127,6 +128,21 @@ namespace ACSVM
       // message to stderr.
       virtual void printKill(Thread *thread, Word type, Word data);
 
+      // Profiling hooks, called by threads only while codeProfile is set.
+      // Default behavior is to do nothing.
+      //    profileBegin    - Thread is about to run for this tic.
+      //    profileCall     - Thread is about to call a function.
+      //    profileCallFunc - Thread is about to make a CallFunc call.
+      //    profileCallSpec - Thread is about to make a CallSpec call.
+      //    profileEnd      - Thread is done running for this tic.
+      //    profileRetn     - Thread is about to return from a function.
+      virtual void profileBegin(Thread *) {}
+      virtual void profileCall(Thread *, Function *) {}
+      virtual void profileCallFunc(Thread *, Word /*func*/) {}
+      virtual void profileCallSpec(Thread *, Word /*spec*/) {}
+      virtual void profileEnd(Thread *) {}
+      virtual void profileRetn(Thread *) {}
+
       // Deserializes a ModuleName. Default behavior is to load s and i.
       virtual ModuleName readModuleName(Serial &in) const;
 
@@ -153,6 +169,10 @@ namespace ACSVM
 
       StringTable stringTable;
 
+      // Blocks for thread-local arrays, kept zeroed. Trimmed whenever a map
+      // is reset.
+      Pool arrayPool;
+
       // Used when a deferred script is started. Default is null.
       ScriptStartFunc funcScriptStartDeferred;
 
@@ -166,9 +186,25 @@ namespace ACSVM
       // Default number of script variables. Default is 20.
       Word scriptLocRegC;
 
+      std::size_t threadAllocC;    // Threads handed out by getFreeThread.
+      std::size_t threadAllocNewC; // Threads that had to be allocated.
+
       // If true, delays last an extra tic as in Hexen. Default is false.
       bool longDelay : 1;
 
+      // If true, common code sequences are fused into single codes when
+      // modules are loaded. Default is true.
+      bool codeFuse : 1;
+
+      // If true, every fused code is checked against the plain sequence it
+      // replaced, killing the thread on a mismatch. Default is false.
+      bool codeFuseCheck : 1;
+
+      // If true, threads count dispatched codes and call the profile hooks.
+      // Codes are then dispatched through a counting stub, so this costs
+      // nothing while off. Default is false.
+      bool codeProfile : 1;
+
 
       // Prints an array to a print buffer, truncating elements of the array to
       // fit char.
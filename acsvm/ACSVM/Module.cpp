@@ -13,6 +13,8 @@
 #include "Module.hpp"
 
 #include "Array.hpp"
+#include "Code.hpp"
+#include "CodeData.hpp"
 #include "Environment.hpp"
 #include "Function.hpp"
 #include "Init.hpp"
@@ -20,6 +22,44 @@
 #include "Script.hpp"
 
 
+//----------------------------------------------------------------------------|
+// Static Functions                                                           |
+//
+
+namespace ACSVM
+{
+   //
+   // FuseCodeDrop
+   //
+   static Code FuseCodeDrop(Code op, bool lit)
+   {
+      switch(op)
+      {
+      case Code::AddU: return lit ? Code::Fuse_Drop_AddU_LocLit : Code::Fuse_Drop_AddU_LocLoc;
+      case Code::SubU: return lit ? Code::Fuse_Drop_SubU_LocLit : Code::Fuse_Drop_SubU_LocLoc;
+      default:         return Code::None;
+      }
+   }
+
+   //
+   // FuseCodeJcnd
+   //
+   static Code FuseCodeJcnd(Code op, bool lit)
+   {
+      switch(op)
+      {
+      case Code::CmpI_GE: return lit ? Code::Fuse_Jcnd_CmpI_GE_LocLit : Code::Fuse_Jcnd_CmpI_GE_LocLoc;
+      case Code::CmpI_GT: return lit ? Code::Fuse_Jcnd_CmpI_GT_LocLit : Code::Fuse_Jcnd_CmpI_GT_LocLoc;
+      case Code::CmpI_LE: return lit ? Code::Fuse_Jcnd_CmpI_LE_LocLit : Code::Fuse_Jcnd_CmpI_LE_LocLoc;
+      case Code::CmpI_LT: return lit ? Code::Fuse_Jcnd_CmpI_LT_LocLit : Code::Fuse_Jcnd_CmpI_LT_LocLoc;
+      case Code::CmpU_EQ: return lit ? Code::Fuse_Jcnd_CmpU_EQ_LocLit : Code::Fuse_Jcnd_CmpU_EQ_LocLoc;
+      case Code::CmpU_NE: return lit ? Code::Fuse_Jcnd_CmpU_NE_LocLit : Code::Fuse_Jcnd_CmpU_NE_LocLoc;
+      default:            return Code::None;
+      }
+   }
+}
+
+
 //----------------------------------------------------------------------------|
 // Extern Functions                                                           |
 //
@@ -56,6 +96,64 @@ namespace ACSVM
       reset();
    }
 
+   //
+   // Module::fuseCode
+   //
+   // Writes fused codes over the first code of common sequences. opV holds
+   // the index of every translated code in order, so operands are never taken
+   // for codes. Only the first word of a sequence changes, which keeps jumps
+   // into the middle of it and saved thread positions valid.
+   //
+   void Module::fuseCode(std::size_t const *opV, std::size_t opC)
+   {
+      for(std::size_t i = 0; i != opC; ++i)
+      {
+         // Read up to four codes that follow each other directly.
+         Code        seq[4];
+         std::size_t seqC;
+         for(seqC = 0; seqC != 4 && i + seqC != opC; ++seqC)
+         {
+            if(seqC && opV[i + seqC] != opV[i + seqC - 1] + 1 + env->getCodeData(seq[seqC - 1])->argc)
+               break;
+
+            seq[seqC] = static_cast<Code>(codeV[opV[i + seqC]]);
+         }
+
+         Code        fuse  = Code::None;
+         std::size_t fuseC = 0;
+
+         if(seqC >= 2 && seq[0] == Code::Push_LocReg &&
+            (seq[1] == Code::Push_Lit || seq[1] == Code::Push_LocReg))
+         {
+            bool lit = seq[1] == Code::Push_Lit;
+
+            if(seqC == 4 && seq[3] == Code::Drop_LocReg)
+               fuse = FuseCodeDrop(seq[2], lit);
+            else if(seqC == 4 && seq[3] == Code::Jcnd_Nil)
+               fuse = FuseCodeJcnd(seq[2], lit);
+
+            if(fuse != Code::None)
+               fuseC = 4;
+            else
+            {
+               fuse  = lit ? Code::Fuse_Push_LocReg_Lit : Code::Fuse_Push_LocReg_LocReg;
+               fuseC = 2;
+            }
+         }
+         else if(seqC >= 2 && seq[0] == Code::Push_Lit && seq[1] == Code::Drop_LocReg)
+         {
+            fuse  = Code::Fuse_Drop_LocReg_Lit;
+            fuseC = 2;
+         }
+
+         if(fuse != Code::None)
+         {
+            codeV[opV[i]] = static_cast<Word>(fuse);
+            i += fuseC - 1;
+         }
+      }
+   }
+
    //
    // Module::refStrings
    //
@@ -138,6 +138,9 @@ namespace ACSVM
       jumpMapV.alloc(tracer.jumpMapC);
 
       tracer.translate(this);
+
+      if(env->codeFuse)
+         fuseCode(tracer.opIndex.data(), tracer.opIndex.size());
    }
 
    //
@@ -0,0 +1,122 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2015-2025 David Hill
+//
+// See COPYING for license information.
+//
+//-----------------------------------------------------------------------------
+//
+// Pool class.
+//
+//-----------------------------------------------------------------------------
+
+#include "Pool.hpp"
+
+#include <cstring>
+#include <new>
+
+
+//----------------------------------------------------------------------------|
+// Extern Objects                                                             |
+//
+
+namespace ACSVM
+{
+   constexpr std::size_t Pool::Step;
+   constexpr std::size_t Pool::MaxSize;
+}
+
+
+//----------------------------------------------------------------------------|
+// Extern Functions                                                           |
+//
+
+namespace ACSVM
+{
+   //
+   // Pool constructor
+   //
+   Pool::Pool() :
+      allocC   {0},
+      allocNewC{0},
+
+      freeV{}
+   {
+   }
+
+   //
+   // Pool destructor
+   //
+   Pool::~Pool()
+   {
+      trim();
+   }
+
+   //
+   // Pool::alloc
+   //
+   void *Pool::alloc(std::size_t size)
+   {
+      ++allocC;
+
+      if(size && size <= MaxSize)
+      {
+         Block *&list = freeV[(size - 1) / Step];
+         if(Block *block = list)
+         {
+            list = block->next;
+            return block;
+         }
+
+         ++allocNewC;
+         return ::operator new((size - 1) / Step * Step + Step);
+      }
+
+      ++allocNewC;
+      return ::operator new(size);
+   }
+
+   //
+   // Pool::allocZero
+   //
+   void *Pool::allocZero(std::size_t size)
+   {
+      std::size_t newC  = allocNewC;
+      void       *block = alloc(size);
+
+      std::memset(block, 0, allocNewC != newC ? size : sizeof(Block));
+      return block;
+   }
+
+   //
+   // Pool::free
+   //
+   void Pool::free(void *block, std::size_t size)
+   {
+      if(size && size <= MaxSize)
+      {
+         Block *&list = freeV[(size - 1) / Step];
+         list = new(block) Block{list};
+      }
+      else
+         ::operator delete(block);
+   }
+
+   //
+   // Pool::trim
+   //
+   void Pool::trim()
+   {
+      for(auto &list : freeV)
+      {
+         while(Block *block = list)
+         {
+            list = block->next;
+            ::operator delete(block);
+         }
+      }
+   }
+}
+
+// EOF
+
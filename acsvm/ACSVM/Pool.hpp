@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2015-2025 David Hill
+//
+// See COPYING for license information.
+//
+//-----------------------------------------------------------------------------
+//
+// Pool class.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef ACSVM__Pool_H__
+#define ACSVM__Pool_H__
+
+#include "Types.hpp"
+
+
+//----------------------------------------------------------------------------|
+// Types                                                                      |
+//
+
+namespace ACSVM
+{
+   //
+   // Pool
+   //
+   // Keeps freed blocks for reuse, in lists by size rounded up to Step bytes.
+   // Blocks bigger than MaxSize go straight to the general allocator.
+   //
+   class Pool
+   {
+   public:
+      Pool();
+      Pool(Pool const &) = delete;
+      ~Pool();
+
+      // Returns an uninitialized block of at least size bytes.
+      void *alloc(std::size_t size);
+
+      // Returns a zeroed block. Only for pools whose blocks all come back
+      // zeroed, so that a reused block just needs its list link cleared.
+      void *allocZero(std::size_t size);
+
+      // size must be the same as was passed to alloc.
+      void free(void *block, std::size_t size);
+
+      // Releases all kept blocks to the general allocator.
+      void trim();
+
+      std::size_t allocC;    // Blocks handed out.
+      std::size_t allocNewC; // Blocks that came from the general allocator.
+
+
+      static constexpr std::size_t Step    = 16;
+      static constexpr std::size_t MaxSize = 2048;
+
+   private:
+      struct Block {Block *next;};
+
+      Block *freeV[MaxSize / Step];
+   };
+}
+
+#endif//ACSVM__Pool_H__
+
@@ -25,6 +25,7 @@
 #include "Thread.hpp"
 
 #include <algorithm>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -62,6 +63,21 @@ namespace ACSVM
       HashMapFixed<String *, Script *> scriptStr;
 
       HashMapFixed<Script *, Thread *> scriptThread;
+
+      // Threads that execute every tic, in threadActive order.
+      ListLink<Thread> threadRun;
+
+      // Delayed threads, by schedTic modulo TimerWheelSize.
+      ListLink<Thread> threadTimer[TimerWheelSize];
+
+      // Threads waiting on a script, by that script.
+      std::unordered_map<Script *, ListLink<Thread>> threadWaitScr;
+
+      // Threads woken by the timer this tic.
+      std::vector<Thread *> threadWoken;
+
+      // Next schedSeq to hand out.
+      std::size_t threadSeq = 0;
    };
 }
 
@@ -72,6 +88,7 @@ namespace ACSVM
 
 namespace ACSVM
 {
+   constexpr std::size_t MapScope::TimerWheelSize;
    constexpr std::size_t ModuleScope::ArrC;
    constexpr std::size_t ModuleScope::RegC;
 }
@@ -568,6 +585,8 @@ namespace ACSVM
 
       module0{nullptr},
 
+      execTic{0},
+
       active       {false},
       clampCallSpec{false},
 
@@ -714,14 +733,22 @@ namespace ACSVM
          delete action;
       }
 
-      // Execute running threads.
-      for(auto itr = threadActive.begin(), end = threadActive.end(); itr != end;)
+      ++execTic;
+      threadWakeTimer();
+
+      // Execute running threads. Sleeping and waiting threads are parked off
+      // the run queue, which stays in threadActive order so the ones that do
+      // run keep their relative order.
+      for(auto link = pd->threadRun.next; link != &pd->threadRun;)
       {
-         itr->exec();
-         if(itr->state == ThreadState::Inactive)
-            freeThread(&*itr++);
+         Thread *thread = link->obj;
+         thread->exec();
+         link = link->next;
+
+         if(thread->state == ThreadState::Inactive)
+            freeThread(thread);
          else
-            ++itr;
+            threadPark(thread);
       }
    }
 
@@ -865,6 +892,7 @@ namespace ACSVM
          Thread *thread = env->getFreeThread();
          thread->link.insert(&threadActive);
          thread->loadState(in);
+         threadEnqueue(thread);
 
          if(in.readByte())
          {
@@ -917,9 +945,16 @@ namespace ACSVM
          env->freeThread(threadActive.next->obj);
       }
 
+      // This map's threads no longer hold any array blocks, so let the kept
+      // ones go rather than carry the peak over to the next map.
+      env->arrayPool.trim();
+
       while(scriptAction.next->obj)
          delete scriptAction.next->obj;
 
+      pd->threadWaitScr.clear();
+      pd->threadSeq = 0;
+
       active = false;
 
       pd->scopes.free();
@@ -1027,6 +1062,7 @@ namespace ACSVM
          {
          case ThreadState::Paused:
             thread->state = ThreadState::Running;
+            threadWake(thread);
             return true;
 
          default:
@@ -1165,7 +1201,9 @@ namespace ACSVM
 
       default:
          (*itr)->state = ThreadState::Stopped;
+         threadWake(*itr);
          (*itr)        = nullptr;
+         threadWakeScript(script);
          return true;
       }
    }
@@ -1187,6 +1225,150 @@ namespace ACSVM
          return false;
    }
 
+   //
+   // MapScope::threadEnqueue
+   //
+   // Puts a thread just added to threadActive at the end of the run queue.
+   //
+   void MapScope::threadEnqueue(Thread *thread)
+   {
+      thread->schedSeq = pd->threadSeq++;
+      thread->sched    = ThreadSched::Run;
+      thread->schedLink.relink(&pd->threadRun);
+   }
+
+   //
+   // MapScope::threadPark
+   //
+   // Takes a thread off the run queue after executing it, if it has nothing
+   // to do for a while.
+   //
+   void MapScope::threadPark(Thread *thread)
+   {
+      // A delay of 1 ends next tic anyway.
+      if(thread->delay > 1)
+      {
+         // Thread::exec counts the delay down once per tic and resumes the
+         // thread when it reaches 0, which is this many tics from now.
+         thread->schedTic = execTic + thread->delay;
+         thread->sched    = ThreadSched::Timer;
+         thread->schedLink.relink(&pd->threadTimer[thread->schedTic % TimerWheelSize]);
+         return;
+      }
+
+      if(thread->delay)
+         return;
+
+      switch(thread->state.state)
+      {
+      case ThreadState::Paused:
+         thread->sched = ThreadSched::Idle;
+         thread->schedLink.unlink();
+         break;
+
+      case ThreadState::WaitScrI:
+      case ThreadState::WaitScrS:
+         {
+            Script *script = thread->state == ThreadState::WaitScrI ?
+               findScript(thread->state.data) :
+               findScript(getString(thread->state.data));
+
+            // A missing script is never active, so nothing would wake it.
+            if(!script)
+               break;
+
+            thread->sched = ThreadSched::WaitScr;
+            thread->schedLink.relink(&pd->threadWaitScr[script]);
+         }
+         break;
+
+      default:
+         // Tag waits depend on the game world, so they are checked every tic.
+         break;
+      }
+   }
+
+   //
+   // MapScope::threadReady
+   //
+   // Puts a parked thread back in the run queue at its place in order.
+   //
+   void MapScope::threadReady(Thread *thread)
+   {
+      auto pos = &pd->threadRun;
+      while(pos->prev != &pd->threadRun && pos->prev->obj->schedSeq > thread->schedSeq)
+         pos = pos->prev;
+
+      thread->sched = ThreadSched::Run;
+      thread->schedLink.relink(pos);
+   }
+
+   //
+   // MapScope::threadWake
+   //
+   // Called when a thread's state is changed from outside. Timer threads are
+   // left alone, since their delay runs out before the state is looked at.
+   //
+   void MapScope::threadWake(Thread *thread)
+   {
+      if(thread->sched == ThreadSched::WaitScr || thread->sched == ThreadSched::Idle)
+         threadReady(thread);
+   }
+
+   //
+   // MapScope::threadWakeScript
+   //
+   // Called when the script may have stopped being active. The woken threads
+   // check for themselves and park again if it is still running.
+   //
+   void MapScope::threadWakeScript(Script *script)
+   {
+      auto itr = pd->threadWaitScr.find(script);
+      if(itr == pd->threadWaitScr.end())
+         return;
+
+      while(Thread *thread = itr->second.next->obj)
+         threadReady(thread);
+   }
+
+   //
+   // MapScope::threadWakeTimer
+   //
+   // Moves the threads whose delay ends this tic back into the run queue.
+   //
+   void MapScope::threadWakeTimer()
+   {
+      auto &slot  = pd->threadTimer[execTic % TimerWheelSize];
+      auto &woken = pd->threadWoken;
+
+      // Longer delays stay in the slot for another turn of the wheel.
+      woken.clear();
+      for(auto &thread : slot)
+      {
+         if(thread.schedTic == execTic)
+            woken.push_back(&thread);
+      }
+
+      if(woken.empty())
+         return;
+
+      std::sort(woken.begin(), woken.end(),
+         [](Thread *l, Thread *r) {return l->schedSeq < r->schedSeq;});
+
+      // Merge into the run queue in one pass.
+      auto pos = pd->threadRun.next;
+      for(Thread *thread : woken)
+      {
+         while(pos != &pd->threadRun && pos->obj->schedSeq < thread->schedSeq)
+            pos = pos->next;
+
+         // Last tic of the delay, which Thread::exec counts down to 0.
+         thread->delay = 1;
+         thread->sched = ThreadSched::Run;
+         thread->schedLink.relink(pos);
+      }
+   }
+
    //
    // MapScope::unlockStrings
    //
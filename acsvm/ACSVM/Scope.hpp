@@ -209,6 +209,10 @@ namespace ACSVM
       bool scriptStop(Script *script);
       bool scriptStop(ScriptName name, ScopeID scope);
 
+      void threadEnqueue(Thread *thread);
+      void threadWake(Thread *thread);
+      void threadWakeScript(Script *script);
+
       void unlockStrings() const;
 
       Environment *const env;
@@ -222,9 +226,15 @@ namespace ACSVM
       // Used for untagged string lookup.
       Module *module0;
 
+      // Number of tics executed, for the timer wheel.
+      Word execTic;
+
       bool active;
       bool clampCallSpec;
 
+
+      static constexpr std::size_t TimerWheelSize = 256;
+
    protected:
       void freeThread(Thread *thread);
 
@@ -234,6 +244,10 @@ namespace ACSVM
       void loadModules(Serial &in);
       void loadThreads(Serial &in);
 
+      void threadPark(Thread *thread);
+      void threadReady(Thread *thread);
+      void threadWakeTimer();
+
       void saveModules(Serial &out) const;
       void saveThreads(Serial &out) const;
 
@@ -43,7 +43,10 @@ namespace ACSVM
       //
       // alloc
       //
-      void alloc(std::size_t count)
+      // New elements are constructed from args.
+      //
+      template<typename... Args>
+      void alloc(std::size_t count, Args const &...args)
       {
          // Possibly reallocate underlying storage.
          if(static_cast<std::size_t>(storeEnd - activeEnd) < count)
@@ -78,20 +81,21 @@ namespace ACSVM
          }
 
          active = activeEnd;
-         while(count--) new(activeEnd++) T{};
+         while(count--) new(activeEnd++) T{args...};
       }
 
       //
       // allocLoad
       //
       // Allocates storage for loading from saved state. countFull elements are
-      // value-initialized and count elements are made available. That is, they
+      // constructed from args and count elements are made available. That is, they
       // should correspond to a prior call to sizeFull and size, respectively.
       //
-      void allocLoad(std::size_t countFull, std::size_t count)
+      template<typename... Args>
+      void allocLoad(std::size_t countFull, std::size_t count, Args const &...args)
       {
          clear();
-         alloc(countFull);
+         alloc(countFull, args...);
          active = activeEnd - count;
       }
 
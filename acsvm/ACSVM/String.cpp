@@ -14,6 +14,7 @@
 
 #include "BinaryIO.hpp"
 #include "HashMap.hpp"
+#include "Pool.hpp"
 #include "Serial.hpp"
 
 #include <new>
@@ -33,6 +34,10 @@ namespace ACSVM
    {
       std::vector<Word> freeIdx;
 
+      // Collected strings are freed back here, as scripts that build strings
+      // tend to make and drop lots of short ones.
+      Pool pool;
+
       HashMapKeyObj<StringData, String, &String::link> stringByData{64, 64};
       std::vector<String *>                            stringByIdx;
    };
@@ -63,18 +68,26 @@ namespace ACSVM
    //
    // String::Delete
    //
-   void String::Delete(String *str)
+   void String::Delete(String *str, Pool *pool)
    {
+      std::size_t size = sizeof(String) + str->len + 1;
+
       str->~String();
-      operator delete(str);
+
+      if(pool)
+         pool->free(str, size);
+      else
+         operator delete(str);
    }
 
    //
    // String::New
    //
-   String *String::New(StringData const &data, Word idx)
+   String *String::New(StringData const &data, Word idx, Pool *pool)
    {
-      String *str = static_cast<String *>(operator new(sizeof(String) + data.len + 1));
+      std::size_t size = sizeof(String) + data.len + 1;
+
+      String *str = static_cast<String *>(pool ? pool->alloc(size) : operator new(size));
       char   *buf = reinterpret_cast<char *>(str + 1);
 
       memcpy(buf, data.str, data.len);
@@ -86,11 +99,12 @@ namespace ACSVM
    //
    // String::Read
    //
-   String *String::Read(Serial &in, Word idx)
+   String *String::Read(Serial &in, Word idx, Pool *pool)
    {
-      std::size_t len = ReadVLN<std::size_t>(in);
+      std::size_t len  = ReadVLN<std::size_t>(in);
+      std::size_t size = sizeof(String) + len + 1;
 
-      String *str = static_cast<String *>(operator new(sizeof(String) + len + 1));
+      String *str = static_cast<String *>(pool ? pool->alloc(size) : operator new(size));
       char   *buf = reinterpret_cast<char *>(str + 1);
 
       in.read(buf, len);
@@ -115,7 +129,7 @@ namespace ACSVM
       strV{nullptr},
       strC{0},
 
-      strNone{String::New({"", 0, 0}, 0)},
+      strNone{String::New({"", 0, 0}, 0, nullptr)},
 
       pd{new PrivData}
    {
@@ -151,7 +165,7 @@ namespace ACSVM
 
       delete pd;
 
-      String::Delete(strNone);
+      String::Delete(strNone, nullptr);
    }
 
    //
@@ -183,7 +197,7 @@ namespace ACSVM
          pd->freeIdx.pop_back();
       }
 
-      String *str = String::New(data, idx);
+      String *str = String::New(data, idx, &pd->pool);
       pd->stringByIdx[idx] = str;
       pd->stringByData.insert(str);
       return *str;
@@ -197,7 +211,7 @@ namespace ACSVM
       for(auto &str : pd->stringByIdx)
       {
          if(str != strNone)
-            String::Delete(str);
+            String::Delete(str, &pd->pool);
       }
 
       pd->freeIdx.clear();
@@ -230,13 +244,21 @@ namespace ACSVM
             pd->stringByIdx[str.idx] = strNone;
             pd->freeIdx.push_back(str.idx);
             pd->stringByData.unlink(&str);
-            String::Delete(&str);
+            String::Delete(&str, &pd->pool);
          }
          else
             ++itr;
       }
    }
 
+   //
+   // StringTable::getPool
+   //
+   Pool const &StringTable::getPool() const
+   {
+      return pd->pool;
+   }
+
    //
    // StringTable::loadState
    //
@@ -249,7 +271,7 @@ namespace ACSVM
       else
       {
          pd      = new PrivData;
-         strNone = String::New({"", 0, 0}, 0);
+         strNone = String::New({"", 0, 0}, 0, nullptr);
       }
 
       auto count = ReadVLN<std::size_t>(in);
@@ -262,7 +284,7 @@ namespace ACSVM
       {
          if(in.readByte())
          {
-            String *str = String::Read(in, idx);
+            String *str = String::Read(in, idx, &pd->pool);
             str->lock = ReadVLN<std::size_t>(in);
             pd->stringByIdx[idx] = str;
             pd->stringByData.insert(str);
@@ -80,11 +80,12 @@ namespace ACSVM
       ListLink<String> link;
 
 
-      static void Delete(String *str);
+      // If pool is null, uses the general allocator.
+      static void Delete(String *str, Pool *pool);
 
-      static String *New(StringData const &data, Word idx);
+      static String *New(StringData const &data, Word idx, Pool *pool);
 
-      static String *Read(Serial &in, Word idx);
+      static String *Read(Serial &in, Word idx, Pool *pool);
 
       static void Write(Serial &out, String *in);
    };
@@ -110,6 +111,9 @@ namespace ACSVM
 
       String &getNone() {return *strNone;}
 
+      // Where strings are allocated from, for its counters.
+      Pool const &getPool() const;
+
       void loadState(Serial &in);
 
       void saveState(Serial &out) const;
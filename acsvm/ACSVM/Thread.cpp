@@ -36,6 +36,7 @@ namespace ACSVM
       env{env_},
 
       link{this},
+      schedLink{this},
 
       codePtr {nullptr},
       module  {nullptr},
@@ -45,7 +46,13 @@ namespace ACSVM
       scopeMod{nullptr},
       script  {nullptr},
       delay   {0},
-      result  {0}
+      result  {0},
+
+      schedSeq{0},
+      schedTic{0},
+      sched   {ThreadSched::None},
+
+      profileCodeC{0}
    {
    }
 
@@ -95,7 +102,7 @@ namespace ACSVM
 
       countFull = ReadVLN<std::size_t>(in);
       count     = ReadVLN<std::size_t>(in);
-      localArr.allocLoad(countFull, count);
+      localArr.allocLoad(countFull, count, &env->arrayPool);
       for(auto itr = localArr.beginFull(), end = localArr.end(); itr != end; ++itr)
          itr->loadState(in);
 
@@ -181,7 +188,7 @@ namespace ACSVM
       WriteVLN(out, scopeHub->id);
       WriteVLN(out, scopeMap->id);
       env->writeScript(out, script);
-      WriteVLN(out, delay);
+      WriteVLN(out, sched == ThreadSched::Timer ? schedTic - scopeMap->execTic : delay);
       WriteVLN(out, result);
 
       WriteVLN(out, callStk.size());
@@ -220,6 +227,7 @@ namespace ACSVM
       Word const *argV, Word argC)
    {
       link.insert(&map->threadActive);
+      map->threadEnqueue(this);
 
       script  = script_;
       module  = script->module;
@@ -232,7 +240,7 @@ namespace ACSVM
 
       callStk.reserve(CallStkSize);
       dataStk.reserve(DataStkSize);
-      localArr.alloc(script->locArrC);
+      localArr.alloc(script->locArrC, &env->arrayPool);
       localReg.alloc(script->locRegC);
 
       std::copy(argV, argV + std::min<Word>(argC, script->argC), &localReg[0]);
@@ -256,6 +264,10 @@ namespace ACSVM
 
       // Set state.
       state = ThreadState::Inactive;
+
+      // Threads waiting on this script can check it again.
+      if(scopeMap && script)
+         scopeMap->threadWakeScript(script);
    }
 
    //
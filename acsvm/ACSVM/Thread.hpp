@@ -82,6 +82,20 @@ namespace ACSVM
       Word type;
    };
 
+   //
+   // ThreadSched
+   //
+   // Where MapScope keeps a thread between executions.
+   //
+   enum class ThreadSched
+   {
+      None,    // Not in a map's run queue.
+      Run,     // Executed every tic.
+      Timer,   // Delayed, on the timer wheel until schedTic.
+      WaitScr, // Waiting on a script, on that script's wait list.
+      Idle,    // Paused, until resumed or stopped.
+   };
+
    //
    // ThreadInfo
    //
@@ -124,6 +138,7 @@ namespace ACSVM
       Environment *const env;
 
       ListLink<Thread> link;
+      ListLink<Thread> schedLink; // Run queue, timer wheel slot, or wait list.
 
       Stack<CallFrame> callStk;
       Stack<Word>      dataStk;
@@ -142,11 +157,21 @@ namespace ACSVM
       Word         delay;   // Execution delay tics.
       Word         result;  // Code-defined thread result.
 
+      std::size_t  schedSeq; // Position in the map's execution order.
+      Word         schedTic; // Tic to resume on, if on the timer wheel.
+      ThreadSched  sched;
+
+      std::size_t  profileCodeC; // Codes dispatched while profiling.
+
 
       static constexpr std::size_t CallStkSize =   8;
       static constexpr std::size_t DataStkSize = 256;
 
    private:
+      void execCode(bool profile);
+
+      void profileCode(Word code, Word const *argV);
+
       CallFrame readCallFrame(Serial &in) const;
 
       void writeCallFrame(Serial &out, CallFrame const &in) const;
@@ -74,11 +74,73 @@
 #define DeclCase(name) case static_cast<Word>(Code::name)
 #endif
 
+//
+// FuseBegin
+//
+// In the validation mode, runs the plain sequence under a fused code on the
+// side, before the fused code itself.
+//
+#define FuseBegin() \
+   if(env->codeFuseCheck) \
+      fuseRef = FusePlain(this, codePtr); \
+   else \
+      ((void)0)
+
+//
+// FuseEnd
+//
+// In the validation mode, kills the thread if the fused code came out
+// different from the plain sequence.
+//
+#define FuseEnd() \
+   if(env->codeFuseCheck && !FuseMatch(this, fuseRef)) \
+   { \
+      env->printKill(this, static_cast<Word>(KillType::FuseMismatch), fuseRef.code); \
+      goto thread_stop; \
+   } \
+   else \
+      ((void)0)
+
+//
+// FuseDrop
+//
+#define FuseDrop(name, op, rop) \
+   DeclCase(Fuse_Drop_##name): \
+      FuseBegin(); \
+      localReg[codePtr[5]] = localReg[codePtr[0]] op (rop); \
+      codePtr += 6; \
+      FuseEnd(); \
+      NextCase()
+
+//
+// FuseJcnd
+//
+#define FuseJcnd(name, cmp, rop) \
+   DeclCase(Fuse_Jcnd_##name): \
+      FuseBegin(); \
+      { \
+         Word lop = localReg[codePtr[0]]; \
+         OpFunc_##cmp(lop, rop); \
+         if(lop) \
+            codePtr += 6; \
+         else \
+            BranchTo(codePtr[5]); \
+      } \
+      FuseEnd(); \
+      NextCase()
+
+//
+// FuseJcndSet
+//
+#define FuseJcndSet(cmp) \
+   FuseJcnd(cmp##_LocLit, cmp, codePtr[2]); \
+   FuseJcnd(cmp##_LocLoc, cmp, localReg[codePtr[2]])
+
 //
 // NextCase
 //
 #if ACSVM_DynamicGoto
-#define NextCase() goto *cases[*codePtr++]
+#define NextCase() goto *dispatch[*codePtr++]
 #else
 #define NextCase() goto next_case
 #endif
@@ -254,6 +316,115 @@ namespace ACSVM
       // TODO: Implement this without relying on sign-extending shift.
       lop = static_cast<SWord>(lop) >> (rop & 31);
    }
+
+   //
+   // FuseResult
+   //
+   // What the plain sequence under a fused code did, for the validation mode.
+   //
+   class FuseResult
+   {
+   public:
+      Word const *next;     // Where execution continues.
+      std::size_t stkSize;  // Data stack size after.
+      Word        stkV[2];  // Values pushed, bottom first.
+      std::size_t stkC;
+      Word        reg;      // Local register assigned, if regSet.
+      Word        regVal;
+      bool        regSet;
+      Word        code;     // The fused code.
+   };
+
+   //
+   // FusePlain
+   //
+   // Interprets the codes under the fused code before codePtr. Apart from the
+   // first one, they are all still in place.
+   //
+   static FuseResult FusePlain(Thread *thread, Word const *codePtr)
+   {
+      FuseResult res{};
+      res.code = codePtr[-1];
+
+      std::size_t opC;
+      Code        op;
+      switch(static_cast<Code>(res.code))
+      {
+      case Code::Fuse_Drop_LocReg_Lit:    op = Code::Push_Lit;    opC = 2; break;
+      case Code::Fuse_Push_LocReg_Lit:
+      case Code::Fuse_Push_LocReg_LocReg: op = Code::Push_LocReg; opC = 2; break;
+      default:                            op = Code::Push_LocReg; opC = 4; break;
+      }
+
+      Word        stk[4];
+      std::size_t stkC = 0;
+
+      for(;;)
+      {
+         switch(op)
+         {
+         case Code::Push_Lit:    stk[stkC++] = *codePtr++; break;
+         case Code::Push_LocReg: stk[stkC++] = thread->localReg[*codePtr++]; break;
+
+         case Code::AddU: --stkC; stk[stkC - 1] += stk[stkC]; break;
+         case Code::SubU: --stkC; stk[stkC - 1] -= stk[stkC]; break;
+
+         case Code::CmpI_GE: --stkC; OpFunc_CmpI_GE(stk[stkC - 1], stk[stkC]); break;
+         case Code::CmpI_GT: --stkC; OpFunc_CmpI_GT(stk[stkC - 1], stk[stkC]); break;
+         case Code::CmpI_LE: --stkC; OpFunc_CmpI_LE(stk[stkC - 1], stk[stkC]); break;
+         case Code::CmpI_LT: --stkC; OpFunc_CmpI_LT(stk[stkC - 1], stk[stkC]); break;
+         case Code::CmpU_EQ: --stkC; OpFunc_CmpU_EQ(stk[stkC - 1], stk[stkC]); break;
+         case Code::CmpU_NE: --stkC; OpFunc_CmpU_NE(stk[stkC - 1], stk[stkC]); break;
+
+         case Code::Drop_LocReg:
+            res.reg    = *codePtr++;
+            res.regVal = stk[--stkC];
+            res.regSet = true;
+            break;
+
+         case Code::Jcnd_Nil:
+            if(stk[--stkC])
+               ++codePtr;
+            else
+               codePtr = &thread->module->codeV[*codePtr];
+            break;
+
+         default:
+            // Not a sequence fuseCode makes.
+            res.next = nullptr;
+            return res;
+         }
+
+         if(!--opC)
+            break;
+
+         op = static_cast<Code>(*codePtr++);
+      }
+
+      res.next    = codePtr;
+      res.stkSize = thread->dataStk.size() + stkC;
+      res.stkC    = stkC;
+      std::copy(stk, stk + stkC, res.stkV);
+
+      return res;
+   }
+
+   //
+   // FuseMatch
+   //
+   static bool FuseMatch(Thread *thread, FuseResult const &res)
+   {
+      if(thread->codePtr != res.next || thread->dataStk.size() != res.stkSize)
+         return false;
+
+      for(std::size_t i = 0; i != res.stkC; ++i)
+      {
+         if(thread->dataStk[res.stkC - i] != res.stkV[i])
+            return false;
+      }
+
+      return !res.regSet || thread->localReg[res.reg] == res.regVal;
+   }
 }
 
 
@@ -271,8 +442,42 @@ namespace ACSVM
       if(delay && --delay)
          return;
 
+      if(env->codeProfile)
+      {
+         env->profileBegin(this);
+         execCode(true);
+         env->profileEnd(this);
+      }
+      else
+         execCode(false);
+   }
+
+   //
+   // Thread::execCode
+   //
+   void Thread::execCode(bool profile)
+   {
       auto branches = env->branchLimit;
 
+      FuseResult fuseRef{};
+
+      #if ACSVM_DynamicGoto
+      static void const *const cases[] =
+      {
+         #define ACSVM_CodeList(name, ...) &&case_Code##name,
+         #include "CodeList.hpp"
+      };
+
+      // While profiling, every code goes through case_Profile first.
+      static void const *const casesProfile[] =
+      {
+         #define ACSVM_CodeList(name, ...) &&case_Profile,
+         #include "CodeList.hpp"
+      };
+
+      void const *const *const dispatch = profile ? casesProfile : cases;
+      #endif
+
    exec_intr:
       switch(state.state)
       {
@@ -304,20 +509,21 @@ namespace ACSVM
          break;
       }
 
-      #if ACSVM_DynamicGoto
-      static void const *const cases[] =
-      {
-         #define ACSVM_CodeList(name, ...) &&case_Code##name,
-         #include "CodeList.hpp"
-      };
-      #endif
-
       #if ACSVM_DynamicGoto
       NextCase();
       #else
-      next_case: switch(*codePtr++)
+      next_case:
+      if(profile)
+         profileCode(codePtr[0], codePtr + 1);
+      switch(*codePtr++)
       #endif
       {
+      #if ACSVM_DynamicGoto
+      case_Profile:
+         profileCode(codePtr[-1], codePtr);
+         goto *cases[codePtr[-1]];
+      #endif
+
       DeclCase(Nop):
          NextCase();
 
@@ -386,7 +592,7 @@ namespace ACSVM
             codePtr      = &func->module->codeV[func->codeIdx];
             module       = func->module;
             scopeMod     = scopeMap->getModuleScope(module);
-            localArr.alloc(func->locArrC);
+            localArr.alloc(func->locArrC, &env->arrayPool);
             localReg.alloc(func->locRegC);
 
             // Read arguments.
@@ -614,6 +820,45 @@ namespace ACSVM
          std::swap(dataStk[2], dataStk[1]);
          NextCase();
 
+         //================================================
+         // Fused codes.
+         //
+
+      DeclCase(Fuse_Drop_LocReg_Lit):
+         FuseBegin();
+         localReg[codePtr[2]] = codePtr[0];
+         codePtr += 3;
+         FuseEnd();
+         NextCase();
+
+      DeclCase(Fuse_Push_LocReg_Lit):
+         FuseBegin();
+         dataStk.push(localReg[codePtr[0]]);
+         dataStk.push(codePtr[2]);
+         codePtr += 3;
+         FuseEnd();
+         NextCase();
+
+      DeclCase(Fuse_Push_LocReg_LocReg):
+         FuseBegin();
+         dataStk.push(localReg[codePtr[0]]);
+         dataStk.push(localReg[codePtr[2]]);
+         codePtr += 3;
+         FuseEnd();
+         NextCase();
+
+         FuseDrop(AddU_LocLit, +, codePtr[2]);
+         FuseDrop(AddU_LocLoc, +, localReg[codePtr[2]]);
+         FuseDrop(SubU_LocLit, -, codePtr[2]);
+         FuseDrop(SubU_LocLoc, -, localReg[codePtr[2]]);
+
+         FuseJcndSet(CmpI_GE);
+         FuseJcndSet(CmpI_GT);
+         FuseJcndSet(CmpI_LE);
+         FuseJcndSet(CmpI_LT);
+         FuseJcndSet(CmpU_EQ);
+         FuseJcndSet(CmpU_NE);
+
          //================================================
          // Unary operator codes.
          //
@@ -637,6 +882,48 @@ namespace ACSVM
    thread_stop:
       stop();
    }
+
+   //
+   // Thread::profileCode
+   //
+   // Counts a code about to be executed and reports calls and returns.
+   //
+   void Thread::profileCode(Word code, Word const *argV)
+   {
+      ++profileCodeC;
+
+      switch(static_cast<Code>(code))
+      {
+      case Code::Call_Lit:
+         if(*argV < module->functionV.size() && module->functionV[*argV])
+            env->profileCall(this, module->functionV[*argV]);
+         break;
+
+      case Code::Call_Stk:
+         if(auto func = env->getFunction(dataStk[1]))
+            env->profileCall(this, func);
+         break;
+
+      case Code::CallFunc:
+      case Code::CallFunc_Lit:
+         env->profileCallFunc(this, argV[1]);
+         break;
+
+      case Code::CallSpec:
+      case Code::CallSpec_Lit:
+      case Code::CallSpec_R1:
+         env->profileCallSpec(this, argV[1]);
+         break;
+
+      case Code::Retn:
+         if(!callStk.empty())
+            env->profileRetn(this);
+         break;
+
+      default:
+         break;
+      }
+   }
 }
 
 // EOF
@@ -375,6 +375,7 @@ namespace ACSVM
 
          // Record jump target.
          codeIndex[iter] = codeItr - module->codeV.data();
+         opIndex.push_back(codeIndex[iter]);
 
          // Read op.
          Word                opCode;
@@ -16,6 +16,7 @@
 #include "Types.hpp"
 
 #include <memory>
+#include <vector>
 
 
 //----------------------------------------------------------------------------|
@@ -50,6 +51,9 @@ namespace ACSVM
 
       std::size_t jumpMapC;
 
+      // Index of every translated code, in order.
+      std::vector<std::size_t> opIndex;
+
    private:
       std::size_t getArgBytes(CodeDataACS0 const *opData, std::size_t iter);
 
@@ -63,6 +63,7 @@ namespace ACSVM
    class Module;
    class ModuleName;
    class ModuleScope;
+   class Pool;
    class PrintBuf;
    class ScopeID;
    class Script;
@@ -25,15 +25,22 @@
 // Authors: James Haley, David Hill
 //
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 #include "z_zone.h"
 
 #include "acs_intr.h"
+#include "c_io.h"
 #include "c_runcmd.h"
 #include "doomstat.h"
 #include "e_hash.h"
 #include "ev_specials.h"
 #include "g_game.h"
+#include "hal/i_directory.h"
 #include "hu_stuff.h"
+#include "m_argv.h"
 #include "m_buffer.h"
 #include "m_collection.h"
 #include "m_qstr.h"
@@ -56,6 +63,7 @@
 #include "ACSVM/Code.hpp"
 #include "ACSVM/CodeData.hpp"
 #include "ACSVM/Error.hpp"
+#include "ACSVM/Function.hpp"
 #include "ACSVM/Module.hpp"
 #include "ACSVM/Scope.hpp"
 #include "ACSVM/Script.hpp"
@@ -76,6 +84,189 @@ int ACS_thingtypes[ACS_NUM_THINGTYPES];
 
 int ACSThread::saveLoadVersion;
 
+//
+// Profiler
+//
+// While acs_profile is on, ACSVM reports every thread's run, function call
+// and return, and CallFunc/CallSpec call to the ACSEnvironment profile hooks.
+// Time and dispatched codes are charged to whichever script or function was
+// running, so each entry only counts its own work, not its callees'.
+//
+
+static bool acs_profile;
+
+//
+// A CallFunc or CallSpec target and how often it was called
+//
+struct acsprofcall_t
+{
+    ACSVM::Word number;  // CallFunc index or special number
+    bool        special; // true for a CallSpec
+    uint64_t    count;
+};
+
+//
+// Totals for a script or function
+//
+struct acsprofile_t
+{
+    qstring  name;
+    bool     function;
+    uint64_t calls;     // script starts or function calls
+    uint64_t runs;      // tics a script's threads ran
+    uint64_t codes;     // codes dispatched
+    int64_t  ns;        // wall time spent in its own code
+    uint64_t funccalls; // CallFunc calls
+    uint64_t speccalls; // CallSpec calls
+
+    PODCollection<acsprofcall_t> targets;
+};
+
+// keyed by Script or Function; modules stay loaded, so the keys stay valid
+static std::unordered_map<const void *, acsprofile_t> acs_profiles;
+
+static ACSThread *acs_profthread; // innermost thread being run
+
+//
+// ACSVM allocation counters: threads, thread-local array blocks and strings,
+// and how many of each had to come from the heap rather than a pool
+//
+struct acsprofalloc_t
+{
+    uint64_t threads, threadsnew;
+    uint64_t arrays, arraysnew;
+    uint64_t strings, stringsnew;
+};
+
+static acsprofalloc_t acs_profallocs;    // totals over the profiled tics
+static acsprofalloc_t acs_profallocmark; // counters when last sampled
+static int            acs_proftics;      // tics sampled
+
+//
+// Reads the current allocation counters
+//
+static acsprofalloc_t ACS_profileAllocCounts()
+{
+    const ACSVM::Pool &strpool = ACSenv.stringTable.getPool();
+    return { ACSenv.threadAllocC,     ACSenv.threadAllocNewC,    //
+             ACSenv.arrayPool.allocC, ACSenv.arrayPool.allocNewC, //
+             strpool.allocC,          strpool.allocNewC };
+}
+
+//
+// Adds up the allocations made since the last sample. Called once a tic.
+//
+static void ACS_profileSampleAllocs()
+{
+    const acsprofalloc_t now = ACS_profileAllocCounts();
+
+    acs_profallocs.threads    += now.threads - acs_profallocmark.threads;
+    acs_profallocs.threadsnew += now.threadsnew - acs_profallocmark.threadsnew;
+    acs_profallocs.arrays     += now.arrays - acs_profallocmark.arrays;
+    acs_profallocs.arraysnew  += now.arraysnew - acs_profallocmark.arraysnew;
+    acs_profallocs.strings    += now.strings - acs_profallocmark.strings;
+    acs_profallocs.stringsnew += now.stringsnew - acs_profallocmark.stringsnew;
+
+    acs_profallocmark = now;
+    ++acs_proftics;
+}
+
+//
+// Current time for the profiler, in nanoseconds
+//
+static int64_t ACS_profileNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+//
+// Names a profiler entry after the module it is in. Map scripts all live in
+// BEHAVIOR lumps, so those are named after the map instead.
+//
+static void ACS_profileName(acsprofile_t &prof, const ACSVM::Module *module, const char *kind,
+                            const ACSVM::String *name, ACSVM::Word number)
+{
+    const char *modname = gamemapname;
+    if(module->name.s && strcasecmp(module->name.s->str, "BEHAVIOR"))
+        modname = module->name.s->str;
+
+    if(name)
+        prof.name.Printf(0, "%s %s \"%s\"", modname, kind, name->str);
+    else
+        prof.name.Printf(0, "%s %s %d", modname, kind, static_cast<int>(number));
+}
+
+//
+// Finds or adds the entry for a script
+//
+static acsprofile_t &ACS_profileForScript(const ACSVM::Script *script)
+{
+    acsprofile_t &prof = acs_profiles[script];
+    if(prof.name.empty())
+        ACS_profileName(prof, script->module, "script", script->name.s, script->name.i);
+    return prof;
+}
+
+//
+// Finds or adds the entry for a function
+//
+static acsprofile_t &ACS_profileForFunction(const ACSVM::Function *func)
+{
+    acsprofile_t &prof = acs_profiles[func];
+    if(prof.name.empty())
+    {
+        ACS_profileName(prof, func->module, "function", func->name, func->idx);
+        prof.function = true;
+    }
+    return prof;
+}
+
+//
+// The entry a thread's work is currently charged to
+//
+static acsprofile_t &ACS_profileOwner(const ACSThread *thread)
+{
+    if(!thread->profileFuncs.isEmpty())
+        return ACS_profileForFunction(thread->profileFuncs.back());
+    return ACS_profileForScript(thread->script);
+}
+
+//
+// Charges the time and codes since the thread's last charge to its owner
+//
+static void ACS_profileCharge(ACSThread *thread)
+{
+    const int64_t now  = ACS_profileNow();
+    acsprofile_t &prof = ACS_profileOwner(thread);
+
+    prof.ns    += now - thread->profileMark;
+    prof.codes += thread->profileCodeC - thread->profileCodes;
+
+    thread->profileMark  = now;
+    thread->profileCodes = thread->profileCodeC;
+}
+
+//
+// Counts a CallFunc or CallSpec call against the thread's owner
+//
+static void ACS_profileCountCall(const ACSThread *thread, ACSVM::Word number, bool special)
+{
+    acsprofile_t &prof = ACS_profileOwner(thread);
+    ++(special ? prof.speccalls : prof.funccalls);
+
+    for(acsprofcall_t &target : prof.targets)
+    {
+        if(target.number == number && target.special == special)
+        {
+            ++target.count;
+            return;
+        }
+    }
+    prof.targets.add({ number, special, 1 });
+}
+
 //
 // Global Functions
 //
@@ -510,6 +701,83 @@ void ACSEnvironment::loadState(ACSVM::Serial &in)
     map    = hub->getMapScope(gamemap);
 }
 
+//
+// ACSEnvironment::profileBegin
+//
+void ACSEnvironment::profileBegin(ACSVM::Thread *thread)
+{
+    auto th = static_cast<ACSThread *>(thread);
+
+    // A script run straight from another one's call stops the caller's clock
+    if(acs_profthread)
+        ACS_profileCharge(acs_profthread);
+
+    th->profileOuter = acs_profthread;
+    acs_profthread   = th;
+
+    ++ACS_profileForScript(th->script).runs;
+
+    th->profileMark  = ACS_profileNow();
+    th->profileCodes = th->profileCodeC;
+}
+
+//
+// ACSEnvironment::profileCall
+//
+void ACSEnvironment::profileCall(ACSVM::Thread *thread, ACSVM::Function *func)
+{
+    auto th = static_cast<ACSThread *>(thread);
+
+    ACS_profileCharge(th);
+    th->profileFuncs.add(func);
+    ++ACS_profileForFunction(func).calls;
+}
+
+//
+// ACSEnvironment::profileCallFunc
+//
+void ACSEnvironment::profileCallFunc(ACSVM::Thread *thread, ACSVM::Word func)
+{
+    ACS_profileCountCall(static_cast<ACSThread *>(thread), func, false);
+}
+
+//
+// ACSEnvironment::profileCallSpec
+//
+void ACSEnvironment::profileCallSpec(ACSVM::Thread *thread, ACSVM::Word spec)
+{
+    ACS_profileCountCall(static_cast<ACSThread *>(thread), spec, true);
+}
+
+//
+// ACSEnvironment::profileEnd
+//
+void ACSEnvironment::profileEnd(ACSVM::Thread *thread)
+{
+    auto th = static_cast<ACSThread *>(thread);
+
+    ACS_profileCharge(th);
+
+    acs_profthread   = th->profileOuter;
+    th->profileOuter = nullptr;
+
+    // The caller's clock runs again from here
+    if(acs_profthread)
+        acs_profthread->profileMark = th->profileMark;
+}
+
+//
+// ACSEnvironment::profileRetn
+//
+void ACSEnvironment::profileRetn(ACSVM::Thread *thread)
+{
+    auto th = static_cast<ACSThread *>(thread);
+
+    ACS_profileCharge(th);
+    if(!th->profileFuncs.isEmpty())
+        th->profileFuncs.pop();
+}
+
 //
 // ACSEnvironment::readModuleName
 //
@@ -573,6 +841,10 @@ void ACSThread::start(ACSVM::Script *script, ACSVM::MapScope *map, const ACSVM::
 
     result = 1;
 
+    profileFuncs.makeEmpty();
+    if(acs_profile)
+        ++ACS_profileForScript(script).calls;
+
     if(infoPtr)
         info = *static_cast<const ACSThreadInfo *>(infoPtr);
     else
@@ -594,7 +866,16 @@ void ACSThread::stop()
 //
 // Called at startup.
 //
-void ACS_Init(void) {}
+void ACS_Init(void)
+{
+    // -noacsfuse runs loaded bytecode exactly as translated, without fused
+    // superinstructions; -acsfusecheck cross-checks every fused code against
+    // the sequence it replaced.
+    if(M_CheckParm("-noacsfuse"))
+        ACSenv.codeFuse = false;
+    if(M_CheckParm("-acsfusecheck"))
+        ACSenv.codeFuseCheck = true;
+}
 
 //
 // ACS_NewGame
@@ -762,6 +1043,9 @@ void ACS_LoadLevelScript(WadDirectory *dir, int lump)
 void ACS_Exec()
 {
     ACSenv.exec();
+
+    if(acs_profile)
+        ACS_profileSampleAllocs();
 }
 
 //
@@ -869,6 +1153,182 @@ bool ACS_TerminateScriptS(const char *str, uint32_t mapnum)
     return ACSenv.map->scriptStop(name, scope);
 }
 
+//=============================================================================
+//
+// Profiler Console Commands
+//
+
+//
+// Sorts profiler entries, biggest first, by one of the dump columns
+//
+static PODCollection<const acsprofile_t *> ACS_profileSorted(const char *key)
+{
+    PODCollection<const acsprofile_t *> sorted;
+    for(const auto &entry : acs_profiles)
+        sorted.add(&entry.second);
+
+    auto value = [key](const acsprofile_t *prof) -> uint64_t {
+        if(!strcasecmp(key, "codes"))
+            return prof->codes;
+        if(!strcasecmp(key, "calls"))
+            return prof->calls;
+        if(!strcasecmp(key, "runs"))
+            return prof->runs;
+        return uint64_t(prof->ns);
+    };
+    std::sort(sorted.begin(), sorted.end(), [&value](const acsprofile_t *a, const acsprofile_t *b) {
+        return value(a) > value(b);
+    });
+
+    return sorted;
+}
+
+//
+// Names a CallFunc or CallSpec target. CallFuncs go by the pcode or ACSE
+// function number that translates to them.
+//
+static void ACS_profileTargetName(qstring &out, const acsprofcall_t &target)
+{
+    if(target.special)
+    {
+        const ev_action_t *action = EV_ACSActionForSpecial(static_cast<int>(target.number));
+        if(action && action->name)
+            out = action->name;
+        else
+            out.Printf(0, "special %d", static_cast<int>(target.number));
+        return;
+    }
+
+    for(ACSVM::Word code = 0; code < 1024; code++)
+    {
+        const ACSVM::CodeDataACS0 *data = ACSenv.findCodeDataACS0(code);
+        if(data && data->transFunc == target.number &&
+           (data->transCode == ACSVM::Code::CallFunc || data->transCode == ACSVM::Code::CallFunc_Lit))
+        {
+            out.Printf(0, "pcode %d", static_cast<int>(code));
+            return;
+        }
+    }
+    for(ACSVM::Word func = 0; func < 1024; func++)
+    {
+        const ACSVM::FuncDataACS0 *data = ACSenv.findFuncDataACS0(func);
+        if(data && data->transFunc == target.number)
+        {
+            out.Printf(0, "callfunc %d", static_cast<int>(func));
+            return;
+        }
+    }
+    out.Printf(0, "internal %d", static_cast<int>(target.number));
+}
+
+VARIABLE_TOGGLE(acs_profile, nullptr, onoff);
+CONSOLE_VARIABLE(acs_profile, acs_profile, 0)
+{
+    ACSenv.codeProfile = acs_profile;
+
+    // only count allocations from here on
+    acs_profallocmark = ACS_profileAllocCounts();
+}
+
+CONSOLE_COMMAND(acs_profile_reset, 0)
+{
+    acs_profiles.clear();
+
+    acs_profallocs    = {};
+    acs_profallocmark = ACS_profileAllocCounts();
+    acs_proftics      = 0;
+}
+
+CONSOLE_COMMAND(acs_profile_dump, 0)
+{
+    const char *key   = Console.argc >= 1 ? Console.argv[0]->constPtr() : "time";
+    const int   count = Console.argc >= 2 ? Console.argv[1]->toInt() : 20;
+
+    if(acs_profiles.empty())
+    {
+        C_Printf("No ACS profile; turn on acs_profile first\n");
+        return;
+    }
+
+    const PODCollection<const acsprofile_t *> sorted = ACS_profileSorted(key);
+
+    if(acs_proftics)
+    {
+        const acsprofalloc_t &a    = acs_profallocs;
+        const double          tics = acs_proftics;
+        C_Printf("Allocations per tic over %d tics (from the heap):\n"
+                 "threads %.2f (%.2f), array blocks %.2f (%.2f), strings %.2f (%.2f)\n",
+                 acs_proftics, a.threads / tics, a.threadsnew / tics, a.arrays / tics, a.arraysnew / tics,
+                 a.strings / tics, a.stringsnew / tics);
+    }
+
+    C_Printf(FC_HI "%8s %9s %6s %6s %5s %5s  %s" FC_NORMAL "\n", "self ms", "codes", "calls", "runs", "cfunc",
+             "cspec", "name");
+    for(size_t i = 0; i < sorted.getLength() && int(i) < count; i++)
+    {
+        const acsprofile_t &prof = *sorted[i];
+        C_Printf("%8.2f %9llu %6llu %6llu %5llu %5llu  %s\n", prof.ns / 1000000.0, (unsigned long long)prof.codes,
+                 (unsigned long long)prof.calls, (unsigned long long)prof.runs, (unsigned long long)prof.funccalls,
+                 (unsigned long long)prof.speccalls, prof.name.constPtr());
+    }
+}
+
+CONSOLE_COMMAND(acs_profile_csv, 0)
+{
+    if(Console.argc < 1)
+    {
+        C_Puts(FC_ERROR "Usage: acs_profile_csv filename [time|codes|calls|runs]");
+        return;
+    }
+
+    const qstring path = userpath / *Console.argv[0];
+    FILE         *f    = I_fopen(path.constPtr(), "w");
+    if(!f)
+    {
+        C_Puts(FC_ERROR "Could not open file for output");
+        return;
+    }
+
+    const PODCollection<const acsprofile_t *> sorted =
+        ACS_profileSorted(Console.argc >= 2 ? Console.argv[1]->constPtr() : "time");
+
+    fputs("kind,name,calls,runs,codes,self_us,callfunc,callspec\n", f);
+    for(const acsprofile_t *prof : sorted)
+    {
+        qstring quoted(prof->name);
+        quoted.makeQuoted();
+        fprintf(f, "%s,%s,%llu,%llu,%llu,%.1f,%llu,%llu\n", prof->function ? "function" : "script", quoted.constPtr(),
+                (unsigned long long)prof->calls, (unsigned long long)prof->runs, (unsigned long long)prof->codes,
+                prof->ns / 1000.0, (unsigned long long)prof->funccalls, (unsigned long long)prof->speccalls);
+    }
+
+    // Calls made by each entry, by target
+    fputs("\nkind,name,call,target,count\n", f);
+    for(const acsprofile_t *prof : sorted)
+    {
+        qstring quoted(prof->name);
+        quoted.makeQuoted();
+        for(const acsprofcall_t &target : prof->targets)
+        {
+            qstring targetname;
+            ACS_profileTargetName(targetname, target);
+            targetname.makeQuoted();
+            fprintf(f, "%s,%s,%s,%s,%llu\n", prof->function ? "function" : "script", quoted.constPtr(),
+                    target.special ? "callspec" : "callfunc", targetname.constPtr(), (unsigned long long)target.count);
+        }
+    }
+
+    // ACSVM allocations over the profiled tics
+    const acsprofalloc_t &a = acs_profallocs;
+    fputs("\ntics,threads,threads_new,array_blocks,array_blocks_new,strings,strings_new\n", f);
+    fprintf(f, "%d,%llu,%llu,%llu,%llu,%llu,%llu\n", acs_proftics, (unsigned long long)a.threads,
+            (unsigned long long)a.threadsnew, (unsigned long long)a.arrays, (unsigned long long)a.arraysnew,
+            (unsigned long long)a.strings, (unsigned long long)a.stringsnew);
+
+    fclose(f);
+    C_Printf(FC_HI "Wrote output to %s\n", path.constPtr());
+}
+
 //=============================================================================
 //
 // Save/Load Code
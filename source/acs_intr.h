@@ -27,6 +27,7 @@
 #ifndef ACS_INTR_H__
 #define ACS_INTR_H__
 
+#include "m_collection.h"
 #include "m_dllist.h"
 #include "p_tick.h"
 #include "r_defs.h"
@@ -208,6 +209,13 @@ public:
 
     virtual void loadState(ACSVM::Serial &in);
 
+    virtual void profileBegin(ACSVM::Thread *thread);
+    virtual void profileCall(ACSVM::Thread *thread, ACSVM::Function *func);
+    virtual void profileCallFunc(ACSVM::Thread *thread, ACSVM::Word func);
+    virtual void profileCallSpec(ACSVM::Thread *thread, ACSVM::Word spec);
+    virtual void profileEnd(ACSVM::Thread *thread);
+    virtual void profileRetn(ACSVM::Thread *thread);
+
     virtual ACSVM::ModuleName readModuleName(ACSVM::Serial &in) const;
 
     virtual void refStrings();
@@ -263,7 +271,10 @@ public:
 class ACSThread : public ACSVM::Thread
 {
 public:
-    explicit ACSThread(ACSVM::Environment *env_) : ACSVM::Thread{ env_ } {}
+    explicit ACSThread(ACSVM::Environment *env_)
+        : ACSVM::Thread{ env_ }, profileOuter{ nullptr }, profileMark{ 0 }, profileCodes{ 0 }
+    {
+    }
 
     virtual ACSVM::ThreadInfo const *getInfo() const { return &info; }
 
@@ -278,6 +289,12 @@ public:
 
     ACSThreadInfo info;
 
+    // Profiler state
+    PODCollection<ACSVM::Function *> profileFuncs; // functions entered, innermost last
+    ACSThread                       *profileOuter; // thread this one is running inside of
+    int64_t                          profileMark;  // time of the last charge, in ns
+    size_t                           profileCodes; // profileCodeC at the last charge
+
     static int saveLoadVersion; // context information stored when saving and loading
 };
 
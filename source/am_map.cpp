@@ -21,7 +21,9 @@
 // Authors: James Haley, Stephen McGranahan, Max Waine, Ioan Chera, Sarah Woodie
 //
 
+#include <algorithm>
 #include <assert.h>
+#include <float.h>
 #include "z_zone.h"
 #include "i_system.h"
 
@@ -39,11 +41,14 @@
 #include "e_inventory.h"
 #include "ev_specials.h"
 #include "g_bind.h"
+#include "m_bbox.h"
+#include "m_compare.h"
 #include "p_inter.h"
 #include "p_maputl.h"
 #include "p_portal.h"
 #include "p_setup.h"
 #include "p_spec.h"
+#include "polyobj.h"
 #include "metaapi.h"
 #include "st_stuff.h"
 #include "r_plane.h"
@@ -1568,6 +1573,271 @@ static void AM_drawMline(mline_t *ml, int color)
     }
 }
 
+//=============================================================================
+//
+// Spatial Index
+//
+// Lines and sectors are binned into a coarse grid built on first use in each
+// level, so that only the cells under the map window have to be looked at.
+// The lines found in the window are clipped and transformed once and kept
+// until the window moves or zooms.
+//
+
+static constexpr double AMGRIDCELL = 256.0; // cell size in map units
+
+struct amgrid_t
+{
+    double originx, originy;
+    int    width, height; // in cells
+    int   *cellstart;     // width * height + 1 offsets into cellitems
+    int   *cellitems;
+};
+
+static amgrid_t am_linegrid;
+static amgrid_t am_sectorgrid;
+
+// Per-item marks so items spanning several cells are only visited once
+static unsigned int *am_linemarks;
+static unsigned int *am_sectormarks;
+static unsigned int  am_markid;
+
+// Polyobject lines move, so they are kept out of the grid
+static int *am_polylines;
+static int  am_numpolylines;
+
+struct amcachedline_t
+{
+    int     index;
+    fline_t fl; // clipped, in frame buffer coordinates
+};
+
+static PODCollection<amcachedline_t> am_visiblelines;
+
+// Window the cached lines were computed for
+static struct amlinecache_t
+{
+    bool   valid;
+    double x, y, x2, y2, scale;
+    int    fx, fy, fw, fh;
+} am_linecache;
+
+//
+// Bins items into a grid by their bounding boxes. getbox returns false for
+// items to leave out.
+//
+template<typename F>
+static void AM_buildGrid(amgrid_t &grid, int numitems, double minx, double miny, double maxx, double maxy, F &&getbox)
+{
+    grid.originx = minx;
+    grid.originy = miny;
+    grid.width   = emax(1, int((maxx - minx) / AMGRIDCELL) + 1);
+    grid.height  = emax(1, int((maxy - miny) / AMGRIDCELL) + 1);
+
+    const int numcells = grid.width * grid.height;
+    int      *counts   = ecalloc(int *, numcells + 1, sizeof(int));
+
+    auto forEachCell = [&grid, &getbox](int item, auto &&func) {
+        double box[4];
+        if(!getbox(item, box))
+            return;
+        int x1 = eclamp(int((box[BOXLEFT] - grid.originx) / AMGRIDCELL), 0, grid.width - 1);
+        int x2 = eclamp(int((box[BOXRIGHT] - grid.originx) / AMGRIDCELL), 0, grid.width - 1);
+        int y1 = eclamp(int((box[BOXBOTTOM] - grid.originy) / AMGRIDCELL), 0, grid.height - 1);
+        int y2 = eclamp(int((box[BOXTOP] - grid.originy) / AMGRIDCELL), 0, grid.height - 1);
+        for(int y = y1; y <= y2; y++)
+            for(int x = x1; x <= x2; x++)
+                func(y * grid.width + x);
+    };
+
+    // count, then turn the counts into offsets and fill in item order so that
+    // each cell's list stays sorted
+    for(int i = 0; i < numitems; i++)
+        forEachCell(i, [counts](int cell) { ++counts[cell + 1]; });
+    for(int cell = 0; cell < numcells; cell++)
+        counts[cell + 1] += counts[cell];
+
+    grid.cellstart = emalloctag(int *, (numcells + 1) * sizeof(int), PU_LEVEL, (void **)&grid.cellstart);
+    memcpy(grid.cellstart, counts, (numcells + 1) * sizeof(int));
+    grid.cellitems =
+        emalloctag(int *, emax(counts[numcells], 1) * sizeof(int), PU_LEVEL, (void **)&grid.cellitems);
+
+    for(int i = 0; i < numitems; i++)
+        forEachCell(i, [&grid, counts, i](int cell) { grid.cellitems[counts[cell]++] = i; });
+
+    efree(counts);
+}
+
+//
+// Builds the line and sector grids for the current level
+//
+static void AM_buildGrids()
+{
+    double minx = DBL_MAX, miny = DBL_MAX, maxx = -DBL_MAX, maxy = -DBL_MAX;
+    for(int i = 0; i < numvertexes; i++)
+    {
+        minx = emin(minx, double(vertexes[i].fx));
+        maxx = emax(maxx, double(vertexes[i].fx));
+        miny = emin(miny, double(vertexes[i].fy));
+        maxy = emax(maxy, double(vertexes[i].fy));
+    }
+    if(minx > maxx)
+        minx = miny = maxx = maxy = 0;
+
+    am_linemarks   = ecalloctag(unsigned int *, emax(numlines, 1), sizeof(unsigned int), PU_LEVEL,
+                                (void **)&am_linemarks);
+    am_sectormarks = ecalloctag(unsigned int *, emax(numsectors, 1), sizeof(unsigned int), PU_LEVEL,
+                                (void **)&am_sectormarks);
+    am_markid      = 0;
+
+    // polyobject lines are drawn every frame from where they are now; use
+    // the mark array to flag them while binning
+    int numpolylines = 0;
+    for(int i = 0; i < numPolyObjects; i++)
+        numpolylines += PolyObjects[i].numLines;
+    am_polylines    = emalloctag(int *, emax(numpolylines, 1) * sizeof(int), PU_LEVEL, (void **)&am_polylines);
+    am_numpolylines = 0;
+    for(int i = 0; i < numPolyObjects; i++)
+    {
+        for(int j = 0; j < PolyObjects[i].numLines; j++)
+        {
+            int linenum = int(PolyObjects[i].lines[j] - lines);
+            if(!am_linemarks[linenum])
+            {
+                am_linemarks[linenum]             = 1;
+                am_polylines[am_numpolylines++] = linenum;
+            }
+        }
+    }
+    std::sort(am_polylines, am_polylines + am_numpolylines);
+
+    AM_buildGrid(am_linegrid, numlines, minx, miny, maxx, maxy, [](int i, double box[4]) {
+        if(am_linemarks[i])
+            return false;
+        const line_t &line = lines[i];
+        box[BOXLEFT]       = emin(line.v1->fx, line.v2->fx);
+        box[BOXRIGHT]      = emax(line.v1->fx, line.v2->fx);
+        box[BOXBOTTOM]     = emin(line.v1->fy, line.v2->fy);
+        box[BOXTOP]        = emax(line.v1->fy, line.v2->fy);
+        return true;
+    });
+
+    // sectors are binned by the extent of their lines, for finding things
+    AM_buildGrid(am_sectorgrid, numsectors, minx, miny, maxx, maxy, [](int i, double box[4]) {
+        const sector_t &sector = sectors[i];
+        if(!sector.linecount)
+            return false;
+        box[BOXLEFT] = box[BOXBOTTOM] = DBL_MAX;
+        box[BOXRIGHT] = box[BOXTOP] = -DBL_MAX;
+        for(int j = 0; j < sector.linecount; j++)
+        {
+            if(am_linemarks[sector.lines[j] - lines])
+                continue; // polyobject
+            for(const vertex_t *v : { sector.lines[j]->v1, sector.lines[j]->v2 })
+            {
+                box[BOXLEFT]   = emin(box[BOXLEFT], double(v->fx));
+                box[BOXRIGHT]  = emax(box[BOXRIGHT], double(v->fx));
+                box[BOXBOTTOM] = emin(box[BOXBOTTOM], double(v->fy));
+                box[BOXTOP]    = emax(box[BOXTOP], double(v->fy));
+            }
+        }
+        return box[BOXLEFT] <= box[BOXRIGHT];
+    });
+
+    memset(am_linemarks, 0, emax(numlines, 1) * sizeof(unsigned int));
+    am_linecache.valid = false;
+}
+
+//
+// Collects the sorted, unique grid items overlapping a map area
+//
+static void AM_queryGrid(const amgrid_t &grid, unsigned int *marks, double x1, double y1, double x2, double y2,
+                         PODCollection<int> &out)
+{
+    out.makeEmpty();
+
+    if(!++am_markid) // wrapped around; start over
+    {
+        memset(am_linemarks, 0, emax(numlines, 1) * sizeof(unsigned int));
+        memset(am_sectormarks, 0, emax(numsectors, 1) * sizeof(unsigned int));
+        am_markid = 1;
+    }
+
+    int cx1 = int(floor((x1 - grid.originx) / AMGRIDCELL));
+    int cx2 = int(floor((x2 - grid.originx) / AMGRIDCELL));
+    int cy1 = int(floor((y1 - grid.originy) / AMGRIDCELL));
+    int cy2 = int(floor((y2 - grid.originy) / AMGRIDCELL));
+    if(cx2 < 0 || cy2 < 0 || cx1 >= grid.width || cy1 >= grid.height)
+        return;
+    cx1 = emax(cx1, 0);
+    cy1 = emax(cy1, 0);
+    cx2 = emin(cx2, grid.width - 1);
+    cy2 = emin(cy2, grid.height - 1);
+
+    for(int y = cy1; y <= cy2; y++)
+    {
+        for(int x = cx1; x <= cx2; x++)
+        {
+            const int cell = y * grid.width + x;
+            for(int i = grid.cellstart[cell]; i < grid.cellstart[cell + 1]; i++)
+            {
+                int item = grid.cellitems[i];
+                if(marks[item] != am_markid)
+                {
+                    marks[item] = am_markid;
+                    out.add(item);
+                }
+            }
+        }
+    }
+
+    // keep the original drawing order
+    std::sort(out.begin(), out.end());
+}
+
+//
+// Makes sure the grids exist for the current level
+//
+static void AM_checkGrids()
+{
+    if(!am_linegrid.cellstart || !am_sectorgrid.cellstart || !am_linemarks || !am_sectormarks || !am_polylines)
+        AM_buildGrids();
+}
+
+//
+// Refreshes the clipped lines in the map window if the window changed
+//
+static void AM_updateVisibleLines()
+{
+    static PODCollection<int> found;
+
+    AM_checkGrids();
+
+    if(am_linecache.valid && am_linecache.x == m_x && am_linecache.y == m_y && am_linecache.x2 == m_x2 &&
+       am_linecache.y2 == m_y2 && am_linecache.scale == scale_mtof && am_linecache.fx == f_x &&
+       am_linecache.fy == f_y && am_linecache.fw == f_w && am_linecache.fh == f_h)
+    {
+        return;
+    }
+
+    am_linecache = { true, m_x, m_y, m_x2, m_y2, scale_mtof, f_x, f_y, f_w, f_h };
+
+    AM_queryGrid(am_linegrid, am_linemarks, m_x, m_y, m_x2, m_y2, found);
+
+    am_visiblelines.makeEmpty();
+    for(int index : found)
+    {
+        const line_t *line = &lines[index];
+        mline_t       ml   = {
+            { line->v1->fx, line->v1->fy },
+            { line->v2->fx, line->v2->fy }
+        };
+        fline_t fl;
+
+        if(AM_clipMline(&ml, &fl))
+            am_visiblelines.add({ index, fl });
+    }
+}
+
 //
 // AM_drawGrid()
 //
@@ -1766,6 +2036,109 @@ inline static bool AM_dontDraw(const line_t &line)
     return line.flags & ML_DONTDRAW || line.frontsector->intflags & SIF_PORTALBOX;
 }
 
+//
+// AM_wallColor
+//
+// Returns the colour a wall line is drawn with, or -1 if it isn't drawn.
+//
+static int AM_wallColor(const line_t *line)
+{
+    // if line has been seen or IDDT has been used
+    if(ddt_cheating || (line->flags & ML_MAPPED))
+    {
+        // check for DONTDRAW flag; those lines are only visible
+        // if using the IDDT cheat.
+        if(AM_dontDraw(*line) && !ddt_cheating)
+            return -1;
+
+        if(!line->backsector) // 1S lines
+        {
+            if(AM_drawAsExitLine(line))
+            {
+                // jff 4/23/98 add exit lines to automap
+                return mapcolor_exit; // exit line
+            }
+            else if(AM_drawAs1sSecret(line))
+            {
+                // jff 1/10/98 add new color for 1S secret sector boundary
+                return mapcolor_secr; // line bounding secret sector
+            }
+            else if(AM_drawAsLockedDoor(line))
+            {
+                int lockColor;
+                if((lockColor = AM_DoorColor(line)) >= 0)
+                    return lockColor ? lockColor : mapcolor_cchg;
+            }
+            else                      // jff 2/16/98 fixed bug
+                return mapcolor_wall; // special was cleared
+        }
+        else // 2S lines
+        {
+            // jff 1/10/98 add color change for all teleporter types
+            if(AM_drawAsTeleporter(line))
+            {
+                // teleporters
+                return mapcolor_tele;
+            }
+            else if(AM_drawAsExitLine(line))
+            {
+                // jff 4/23/98 add exit lines to automap
+                return mapcolor_exit;
+            }
+            else if(AM_drawAsLockedDoor(line))
+            {
+                // jff 1/5/98 this clause implements showing keyed doors
+                if(AM_isDoorClosed(line))
+                {
+                    int lockColor;
+                    if((lockColor = AM_DoorColor(line)) >= 0)
+                        return lockColor ? lockColor : mapcolor_cchg;
+                }
+                else
+                    return mapcolor_cchg; // open keyed door
+            }
+            else if(line->flags & ML_SECRET) // secret door
+            {
+                return mapcolor_wall; // wall color
+            }
+            else if(AM_drawAsClosedDoor(line))
+            {
+                return mapcolor_clsd; // non-secret closed door
+            }
+            else if(AM_drawAs2sSecret(line))
+            {
+                return mapcolor_secr; // line bounding secret sector
+            }
+            else if(AM_different<surf_floor>(*line))
+            {
+                return mapcolor_fchg; // floor level change
+            }
+            else if(AM_different<surf_ceil>(*line))
+            {
+                return mapcolor_cchg; // ceiling level change
+            }
+            else if(mapcolor_flat && ddt_cheating)
+            {
+                return mapcolor_flat; // 2S lines that appear only in IDDT
+            }
+        }
+    }
+    else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
+    {
+        // now draw the lines only visible because the player has computermap
+        if(!AM_dontDraw(*line)) // invisible flag lines do not show
+        {
+            if(mapcolor_flat || !line->backsector || AM_different<surf_floor>(*line) ||
+               AM_different<surf_ceil>(*line))
+            {
+                return mapcolor_unsn;
+            }
+        }
+    } // end else if
+
+    return -1;
+}
+
 //
 // Determines visible lines, draws them.
 // This is LineDef based, not LineSeg based.
@@ -1842,23 +2215,24 @@ static void AM_drawWalls()
     }
 
     // draw the unclipped visible portions of all lines
-    for(i = 0; i < numlines; i++)
+    if(mapportal_overlay && useportalgroups)
     {
-        const line_t *line = &lines[i];
-
-        l.a.x = line->v1->fx;
-        l.a.y = line->v1->fy;
-        l.b.x = line->v2->fx;
-        l.b.y = line->v2->fy;
-
-        if(mapportal_overlay && useportalgroups)
+        // lines of other groups are displaced, so the grid can't be used
+        for(i = 0; i < numlines; i++)
         {
+            const line_t *line = &lines[i];
+
             if(line->frontsector &&
                (line->frontsector->groupid != plrgroup && !P_PortalLayersByPoly(line->frontsector->groupid, plrgroup)))
             {
                 continue;
             }
 
+            l.a.x = line->v1->fx;
+            l.a.y = line->v1->fy;
+            l.b.x = line->v2->fx;
+            l.b.y = line->v2->fy;
+
             if(line->frontsector)
             {
                 linkoffset_t *link = P_GetLinkOffset(line->frontsector->groupid, plrgroup);
@@ -1868,101 +2242,47 @@ static void AM_drawWalls()
                 l.b.x += M_FixedToDouble(link->x);
                 l.b.y += M_FixedToDouble(link->y);
             }
+
+            AM_drawMline(&l, AM_wallColor(line));
         }
+        return;
+    }
 
-        // if line has been seen or IDDT has been used
-        if(ddt_cheating || (line->flags & ML_MAPPED))
-        {
-            // check for DONTDRAW flag; those lines are only visible
-            // if using the IDDT cheat.
-            if(AM_dontDraw(*line) && !ddt_cheating)
-                continue;
+    // Only the lines in the window, from the cache, merged in index order with
+    // the polyobject lines (which move, so they're never cached).
+    AM_updateVisibleLines();
 
-            if(!line->backsector) // 1S lines
-            {
-                if(AM_drawAsExitLine(line))
-                {
-                    // jff 4/23/98 add exit lines to automap
-                    AM_drawMline(&l, mapcolor_exit); // exit line
-                }
-                else if(AM_drawAs1sSecret(line))
-                {
-                    // jff 1/10/98 add new color for 1S secret sector boundary
-                    AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
-                }
-                else if(AM_drawAsLockedDoor(line))
-                {
-                    int lockColor;
-                    if((lockColor = AM_DoorColor(line)) >= 0)
-                        AM_drawMline(&l, lockColor ? lockColor : mapcolor_cchg);
-                }
-                else                                 // jff 2/16/98 fixed bug
-                    AM_drawMline(&l, mapcolor_wall); // special was cleared
-            }
-            else // 2S lines
+    const amcachedline_t *cached    = am_visiblelines.begin();
+    const amcachedline_t *cachedend = am_visiblelines.end();
+    const int            *poly      = am_polylines;
+    const int            *polyend   = am_polylines + am_numpolylines;
+
+    while(cached != cachedend || poly != polyend)
+    {
+        if(poly == polyend || (cached != cachedend && cached->index < *poly))
+        {
+            int color = AM_wallColor(&lines[cached->index]);
+            if(color != -1)
             {
-                // jff 1/10/98 add color change for all teleporter types
-                if(AM_drawAsTeleporter(line))
-                {
-                    // teleporters
-                    AM_drawMline(&l, mapcolor_tele);
-                }
-                else if(AM_drawAsExitLine(line))
-                {
-                    // jff 4/23/98 add exit lines to automap
-                    AM_drawMline(&l, mapcolor_exit);
-                }
-                else if(AM_drawAsLockedDoor(line))
-                {
-                    // jff 1/5/98 this clause implements showing keyed doors
-                    if(AM_isDoorClosed(line))
-                    {
-                        int lockColor;
-                        if((lockColor = AM_DoorColor(line)) >= 0)
-                            AM_drawMline(&l, lockColor ? lockColor : mapcolor_cchg);
-                    }
-                    else
-                        AM_drawMline(&l, mapcolor_cchg); // open keyed door
-                }
-                else if(line->flags & ML_SECRET) // secret door
-                {
-                    AM_drawMline(&l, mapcolor_wall); // wall color
-                }
-                else if(AM_drawAsClosedDoor(line))
-                {
-                    AM_drawMline(&l, mapcolor_clsd); // non-secret closed door
-                }
-                else if(AM_drawAs2sSecret(line))
-                {
-                    AM_drawMline(&l, mapcolor_secr); // line bounding secret sector
-                }
-                else if(AM_different<surf_floor>(*line))
-                {
-                    AM_drawMline(&l, mapcolor_fchg); // floor level change
-                }
-                else if(AM_different<surf_ceil>(*line))
-                {
-                    AM_drawMline(&l, mapcolor_cchg); // ceiling level change
-                }
-                else if(mapcolor_flat && ddt_cheating)
-                {
-                    AM_drawMline(&l, mapcolor_flat); // 2S lines that appear only in IDDT
-                }
+                fline_t fl = cached->fl;
+                if(map_antialias)
+                    AM_drawFlineWu(&fl, color);
+                else
+                    AM_drawFline(&fl, color);
             }
+            ++cached;
         }
-        else if(plr->powers[pw_allmap].isActive()) // computermap visible lines
+        else
         {
-            // now draw the lines only visible because the player has computermap
-            if(!AM_dontDraw(*line)) // invisible flag lines do not show
-            {
-                if(mapcolor_flat || !line->backsector || AM_different<surf_floor>(*line) ||
-                   AM_different<surf_ceil>(*line))
-                {
-                    AM_drawMline(&l, mapcolor_unsn);
-                }
-            }
-        } // end else if
-    } // end for
+            const line_t *line = &lines[*poly++];
+
+            l.a.x = line->v1->fx;
+            l.a.y = line->v1->fy;
+            l.b.x = line->v2->fx;
+            l.b.y = line->v2->fy;
+            AM_drawMline(&l, AM_wallColor(line));
+        }
+    }
 }
 
 //
@@ -2248,10 +2568,27 @@ static void AM_drawThings(int colors, int colorrange)
 {
     fixed_t tx, ty; // SoM: Moved thing coords to variables for linked portals
 
+    static PODCollection<int> visiblesectors;
+
+    // Unless other portal groups are overlaid, things are drawn where they
+    // are, so only the sectors under the map window need to be looked at.
+    // The margin covers the size of the thing glyphs.
+    const bool culled = !(mapportal_overlay && useportalgroups);
+    if(culled)
+    {
+        static constexpr double margin = 64.0;
+
+        AM_checkGrids();
+        AM_queryGrid(am_sectorgrid, am_sectormarks, m_x - margin, m_y - margin, m_x2 + margin, m_y2 + margin,
+                     visiblesectors);
+    }
+
+    const int numvisible = culled ? int(visiblesectors.getLength()) : numsectors;
+
     // for all sectors
-    for(int i = 0; i < numsectors; i++)
+    for(int n = 0; n < numvisible; n++)
     {
-        const Mobj *t = sectors[i].thinglist;
+        const Mobj *t = sectors[culled ? visiblesectors[n] : n].thinglist;
 
         while(t) // for all things in that sector
         {
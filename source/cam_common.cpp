@@ -62,12 +62,11 @@ PathTraverser::PathTraverser(const PTDef &indef, void *incontext)
 //
 // Handles intercepts in order
 //
-bool PathTraverser::traverseIntercepts() const
+bool PathTraverser::traverseIntercepts()
 {
-    PODCollection<intercept_t>::iterator scan, end, in;
+    PODCollection<intercept_t>::iterator scan, end;
 
     size_t    count;
-    fixed_t   dist;
     divline_t dl;
 
     count = intercepts.getLength();
@@ -88,20 +87,17 @@ bool PathTraverser::traverseIntercepts() const
     //
     // go through in order
     //
-    in = nullptr; // shut up compiler warning
+    // Once the intercepts run out, the old search for the nearest one kept
+    // handing out the last one again for each intercept at D_MAXINT; that
+    // is kept, since traversers may count on it.
+    //
+    queue.build(intercepts.begin(), count);
 
+    intercept_t *in = nullptr;
     while(count--)
     {
-        dist = D_MAXINT;
-
-        for(scan = intercepts.begin(); scan < end; scan++)
-        {
-            if(scan->frac < dist)
-            {
-                dist = scan->frac;
-                in   = scan;
-            }
-        }
+        if(intercept_t *next = queue.pop())
+            in = next;
 
         if(in)
         {
@@ -76,7 +76,7 @@ private:
     bool checkLine(size_t linenum);
     bool blockLinesIterator(int x, int y);
     bool blockThingsIterator(int x, int y);
-    bool traverseIntercepts() const;
+    bool traverseIntercepts();
 
     const PTDef def;
     void *const context;
@@ -88,6 +88,7 @@ private:
         bool addedportal;
     } portalguard;
     PODCollection<intercept_t> intercepts;
+    InterceptQueue             queue; // storage reused by every trace this traverser runs
 };
 
 //
@@ -55,6 +55,7 @@
 #include "f_finale.h"
 #include "f_wipe.h"
 #include "g_bind.h"
+#include "g_demobatch.h"
 #include "g_demolog.h"
 #include "g_dmflag.h"
 #include "g_game.h"
@@ -71,6 +72,7 @@
 #include "m_misc.h"
 #include "m_syscfg.h"
 #include "m_qstr.h"
+#include "m_shots.h"
 #include "m_utils.h"
 #include "mn_engin.h"
 #include "p_chase.h"
@@ -755,6 +757,9 @@ static void D_Display()
         D_showMemStats();
 #endif
 
+    // capture the finished frame if a frame dump is running
+    M_FrameDump();
+
     I_FinishUpdate(); // page flip or blit buffer
 
     i_haltimer.EndDisplay();
@@ -1305,10 +1310,16 @@ static void D_DoomInit()
 
     startupmsg("Z_Init", "Init zone memory allocation daemon.");
     Z_Init();
+
     I_AtExit(I_Quit);
 
     FindResponseFile(); // Append response file arguments to command-line
 
+    // Batch demo testing only spawns child processes. No configuration is
+    // loaded yet, so I_Quit won't write any back out.
+    if(G_DemoBatchRequested())
+        I_Exit(G_RunDemoBatch());
+
     // haleyjd 08/18/07: set base path and user path
     D_SetBasePath();
     D_SetUserPath();
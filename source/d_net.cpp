@@ -41,6 +41,7 @@
 #include "g_dmflag.h"
 #include "g_game.h"
 #include "hal/i_timer.h"
+#include "m_compare.h"
 #include "m_random.h"
 #include "mn_engin.h"
 #include "i_net.h"
@@ -89,6 +90,105 @@ void D_DoAdvanceDemo();
 static bool       reboundpacket;
 static doomdata_t reboundstore;
 
+//
+// Per-node connection statistics, kept from the timing and sequence fields
+// of the packets
+//
+struct netnodestats_t
+{
+    bool     heard;        // received anything from the node yet
+    uint16_t lastsendtime; // sendtime of its last packet
+    unsigned lastrecv;     // when that packet arrived (ms)
+    byte     nextsequence; // sequence expected from it
+    byte     sendsequence; // sequence of our next packet to it
+
+    bool   hasrtt;
+    double srtt;   // smoothed round trip time (ms)
+    double rttvar; // smoothed deviation of the round trip time (ms)
+    int    minrtt, maxrtt;
+
+    unsigned packets; // packets received
+    unsigned lost;    // packets skipped in the sequence
+    unsigned stalls;  // losses which the backup tics didn't cover
+};
+
+static netnodestats_t netstats[MAXNETNODES];
+
+//
+// D_updateNodeStats
+//
+// Accounts a received game packet in the statistics of its node
+//
+static void D_updateNodeStats(int netnode)
+{
+    netnodestats_t &ns  = netstats[netnode];
+    const unsigned  now = i_haltimer.GetTicks();
+
+    ++ns.packets;
+
+    // a gap in the sequence is lost packets; a step back is a late one
+    const byte gap = byte(netbuffer->sequence - ns.nextsequence);
+    if(!ns.heard || gap < 128)
+    {
+        if(ns.heard)
+            ns.lost += gap;
+        ns.nextsequence = byte(netbuffer->sequence + 1);
+    }
+
+    ns.heard        = true;
+    ns.lastsendtime = netbuffer->sendtime;
+    ns.lastrecv     = now;
+
+    if(netbuffer->echodelay == NETECHO_NONE)
+        return;
+
+    // time since our echoed packet left, less the time the remote held it
+    const int rtt = uint16_t(uint16_t(now) - netbuffer->echotime - netbuffer->echodelay);
+    if(rtt > 0x7fff) // clocks out of step; discard
+        return;
+
+    if(!ns.hasrtt)
+    {
+        ns.srtt   = rtt;
+        ns.rttvar = rtt / 2.0;
+        ns.minrtt = ns.maxrtt = rtt;
+        ns.hasrtt = true;
+        return;
+    }
+
+    // same smoothing as TCP (RFC 6298)
+    const double deviation = rtt > ns.srtt ? rtt - ns.srtt : ns.srtt - rtt;
+
+    ns.rttvar += (deviation - ns.rttvar) / 4;
+    ns.srtt   += (rtt - ns.srtt) / 8;
+    ns.minrtt  = emin(ns.minrtt, rtt);
+    ns.maxrtt  = emax(ns.maxrtt, rtt);
+}
+
+//
+// D_stampPacket
+//
+// Fills in the sequence and timing fields of a packet to a node
+//
+static void D_stampPacket(int node)
+{
+    netnodestats_t &ns  = netstats[node];
+    const unsigned  now = i_haltimer.GetTicks();
+
+    netbuffer->sequence = ns.sendsequence++;
+    netbuffer->sendtime = uint16_t(now);
+    if(ns.heard && now - ns.lastrecv < NETECHO_NONE)
+    {
+        netbuffer->echotime  = ns.lastsendtime;
+        netbuffer->echodelay = uint16_t(now - ns.lastrecv);
+    }
+    else
+    {
+        netbuffer->echotime  = 0;
+        netbuffer->echodelay = NETECHO_NONE;
+    }
+}
+
 //
 // ExpandTics
 //
@@ -233,6 +333,9 @@ static void GetPackets()
 
         nodeforplayer[netconsole] = netnode;
 
+        if(netnode)
+            D_updateNodeStats(netnode);
+
         // check for retransmit request
         if(resendcount[netnode] <= 0 && (netbuffer->checksum & NCMD_RETRANSMIT))
         {
@@ -253,6 +356,8 @@ static void GetPackets()
         if(realstart > nettics[netnode])
         {
             // stop processing until the other system resends the missed tics
+            if(!remoteresend[netnode])
+                ++netstats[netnode].stalls;
             remoteresend[netnode] = true;
             continue;
         }
@@ -341,11 +446,14 @@ void NetUpdate()
             if(netbuffer->numtics > BACKUPTICS)
                 I_Error("NetUpdate: netbuffer->numtics > BACKUPTICS\n");
 
-            resendto[i] = maketic - doomcom->extratics;
+            // repeat the last extratics tics in the next packet too
+            resendto[i] = emax(maketic - doomcom->extratics, 0);
 
             for(int j = 0; j < netbuffer->numtics; j++)
                 netbuffer->d.cmds[j] = localcmds[(realstart + j) % BACKUPTICS];
 
+            D_stampPacket(i);
+
             if(remoteresend[i])
             {
                 netbuffer->retransmitfrom = nettics[i];
@@ -540,6 +648,7 @@ void D_CheckNetGame()
         nettics[i]      = 0;
         remoteresend[i] = false; // set when local needs tics
         resendto[i]     = 0;     // which tic to start sending
+        netstats[i]     = {};
     }
 
     // I_InitNetwork sets doomcom and netgame
@@ -598,7 +707,10 @@ void D_QuitNetGame()
         for(int j = 1; j < doomcom->numnodes; j++)
         {
             if(nodeingame[j])
+            {
+                D_stampPacket(j);
                 HSendPacket(j, NCMD_EXIT);
+            }
         }
         i_haltimer.Sleep(15);
     }
@@ -886,6 +998,30 @@ CONSOLE_COMMAND(disconnect, cf_netonly)
 }
 */
 
+CONSOLE_COMMAND(netstats, 0)
+{
+    if(!netgame || demoplayback)
+    {
+        C_Printf("Not in a net game\n");
+        return;
+    }
+
+    C_Printf("%d backup tics per packet\n"
+             "node  rtt ms  jitter  min/max    packets  lost  stalls\n",
+             doomcom->extratics);
+    for(int i = 1; i < doomcom->numnodes; i++)
+    {
+        const netnodestats_t &ns = netstats[i];
+        if(!ns.hasrtt)
+        {
+            C_Printf("%4d  %s\n", i, nodeingame[i] ? "no timing yet" : "left");
+            continue;
+        }
+        C_Printf("%4d  %6.1f  %6.1f  %3d/%-5d  %7u  %4u  %6u%s\n", i, ns.srtt, ns.rttvar, ns.minrtt, ns.maxrtt,
+                 ns.packets, ns.lost, ns.stalls, nodeingame[i] ? "" : " (left)");
+    }
+}
+
 VARIABLE_TOGGLE(d_fastrefresh, nullptr, onoff);
 CONSOLE_VARIABLE(d_fastrefresh, d_fastrefresh, 0) {}
 
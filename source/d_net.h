@@ -49,6 +49,11 @@ static constexpr uint32_t NCMD_SETUP      = 0x20000000;
 static constexpr uint32_t NCMD_KILL       = 0x10000000; /* kill game */
 static constexpr uint32_t NCMD_CHECKSUM   = 0x0fffffff;
 
+static constexpr uint16_t NETECHO_NONE = 0xffff;
+
+// Default number of backup tics sent in every packet
+static constexpr int DEFAULTEXTRATICS = 2;
+
 enum
 {
     CMD_SEND = 1,
@@ -78,6 +83,15 @@ struct doomdata_t
     byte player;
     byte numtics;
 
+    // Counts the packets sent to the destination node, to tell losses.
+    byte sequence;
+    // Low 16 bits of milliseconds: when this packet left, the sendtime of the
+    // last packet received from the destination node, and how long it was
+    // held before this reply (NETECHO_NONE if nothing was received yet).
+    uint16_t sendtime;
+    uint16_t echotime;
+    uint16_t echodelay;
+
     union packetdata_u
     {
         byte     data[GAME_OPTION_SIZE];
@@ -133,7 +147,8 @@ struct doomcom_t
     int16_t numnodes;
     // Flag: 1 = no duplication, 2-5 = dup for slow nets.
     int16_t ticdup;
-    // Flag: 1 = send a backup tic in every packet.
+    // Number of already sent tics repeated in every packet, so that a lost
+    // packet is covered by the next ones without a resend.
     int16_t extratics;
     // Flag: 1 = deathmatch.
     int16_t deathmatch;
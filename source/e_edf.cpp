@@ -1163,7 +1163,8 @@ sfxinfo_t NullSound = {
     nullptr,
     0,
     0,
-    0, // data, length, alen, usefulness
+    nullptr,
+    0, // data, length, alen, decode, usefulness
     NullMnemonic, // mnemomnic
     nullptr,
     nullptr, // lfn, pcslfn
@@ -60,6 +60,7 @@
 #include "m_utils.h"
 #include "p_mobj.h"
 #include "p_skin.h"
+#include "s_formats.h"
 #include "s_sndseq.h"
 #include "s_sound.h"
 #include "w_wad.h"
@@ -480,15 +481,14 @@ void E_UpdateSoundCache()
     // be sure all sounds are stopped
     S_StopSounds(true);
 
+    // converted samples share one pool, so they're all freed together
+    S_FinishSoundDecodes();
+
     sfxinfo_t *cursfx = nullptr;
     while((cursfx = sound_namehash.tableIterator(cursfx)))
-    {
-        if(cursfx->data)
-        {
-            efree(cursfx->data);
-            cursfx->data = nullptr;
-        }
-    }
+        cursfx->data = nullptr;
+
+    S_FreeSoundSamples();
 
     // recache sounds if so requested
     if(s_precache)
@@ -0,0 +1,459 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Headless batch demo runner.
+//
+//  -demobatch <listfile|directory> plays every demo of the batch in its own
+//  child process with -fastdemo -nodraw -noblit -nosound, running up to
+//  -batchjobs of them at the same time. The game state is process-wide, so
+//  each demo gets a fresh process. Every command-line argument that is not
+//  part of the batch options (-iwad, -file, -deh, -complevel etc.) is passed
+//  on to the children, so one batch plays against one IWAD/PWAD set. Lines in
+//  a list file may add their own extra arguments after the demo path.
+//
+//  Each child writes a -demolog; the runner reads it back to classify the
+//  demo:
+//  * pass: the demo stream ended after the player exited the last level
+//  * desync: the demo stream ended while still inside a level
+//  * crash: the child never reached the end of the demo stream
+//
+// Authors: Ioan Chera
+//
+
+#if __cplusplus >= 201703L || _MSC_VER >= 1914
+#include "hal/i_platform.h"
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "z_zone.h"
+
+#include "hal/i_directory.h"
+
+#include "d_main.h"
+#include "g_demobatch.h"
+#include "m_argv.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "m_utils.h"
+
+#if EE_CURRENT_PLATFORM != EE_PLATFORM_WINDOWS
+#include <sys/wait.h>
+#endif
+
+//
+// Batch runner options. These are consumed by the parent process and never
+// forwarded to the children.
+//
+static const char *batchparms[] = { "-demobatch", "-batchjobs", "-batchlogs", "-batchcsv" };
+
+//
+// Parameters which the runner sets on its own for each child
+//
+static const char *childparms[] = { "-playdemo", "-play", "-fastdemo", "-timedemo", "-record", "-recorddemo",
+                                    "-demolog" };
+
+enum demoresult_e
+{
+    DEMO_PASS,
+    DEMO_DESYNC,
+    DEMO_CRASH,
+    NUMDEMORESULTS
+};
+
+static const char *resultnames[NUMDEMORESULTS] = { "pass", "desync", "crash" };
+
+//
+// One batch entry. Command lines are prepared by the main thread; the workers
+// only read them and fill in the timing and the process status, so nothing
+// touches the zone heap off the main thread.
+//
+struct demojob_t
+{
+    qstring demo;    // demo path as given
+    qstring extra;   // per-demo arguments from the list file
+    qstring logpath; // -demolog output of the child
+    qstring outpath; // console output of the child
+    qstring command; // full command line
+
+    int    status;  // raw status from system()
+    double seconds; // wall time
+
+    // filled from the log after the run
+    demoresult_e result;
+    int          gametics;
+};
+
+//
+// Checks if the argument at position p belongs to an option in the list.
+// Returns the number of argv entries taken, or 0 if not matched.
+//
+static int G_matchBatchParm(int p, const char *const *parms, size_t numparms, bool takesValue)
+{
+    for(size_t i = 0; i < numparms; ++i)
+    {
+        if(!strcasecmp(myargv[p], parms[i]))
+            return takesValue && p < myargc - 1 ? 2 : 1;
+    }
+    return 0;
+}
+
+//
+// Appends a single argument to a command line, quoted
+//
+static void G_appendQuotedArg(qstring &command, const char *arg)
+{
+    command << " \"" << arg << "\"";
+}
+
+//
+// Builds the arguments forwarded from the parent command line. Batch options,
+// demo playback options and their values are dropped.
+//
+static void G_buildForwardedArgs(qstring &args)
+{
+    for(int p = 1; p < myargc;)
+    {
+        int skip = G_matchBatchParm(p, batchparms, earrlen(batchparms), true);
+        if(!skip)
+            skip = G_matchBatchParm(p, childparms, earrlen(childparms), true);
+        if(skip)
+        {
+            p += skip;
+            continue;
+        }
+        // -nodraw etc. are added again later; don't duplicate them
+        if(strcasecmp(myargv[p], "-nodraw") && strcasecmp(myargv[p], "-noblit") && strcasecmp(myargv[p], "-nosound"))
+            G_appendQuotedArg(args, myargv[p]);
+        ++p;
+    }
+}
+
+//
+// Adds all demo lumps found in a directory, sorted by name so that the
+// summary order is stable between runs.
+//
+static void G_addDemosFromDirectory(const char *path, Collection<demojob_t> &jobs)
+{
+    PODCollection<char *> names;
+    try
+    {
+        for(const fs::directory_entry &ent : fs::directory_iterator(path))
+        {
+            if(!ent.is_regular_file())
+                continue;
+            qstring name(ent.path().generic_u8string().c_str());
+            size_t  dot = name.findLastOf('.');
+            if(dot == qstring::npos || strcasecmp(name.constPtr() + dot, ".lmp"))
+                continue;
+            names.add(name.duplicate());
+        }
+    }
+    catch(const fs::filesystem_error &)
+    {
+        usermsg("G_RunDemoBatch: can't read directory '%s'\n", path);
+        return;
+    }
+
+    qsort(&names[0], names.getLength(), sizeof(char *), [](const void *a, const void *b) {
+        return strcmp(*static_cast<char *const *>(a), *static_cast<char *const *>(b));
+    });
+
+    for(char *name : names)
+    {
+        demojob_t &job = jobs.addNew();
+        job.demo       = name;
+        efree(name);
+    }
+}
+
+//
+// Reads a list file. Each non-empty line names a demo, optionally followed
+// by extra arguments for that demo. Lines starting with # or ; are comments.
+//
+static void G_addDemosFromList(const char *path, Collection<demojob_t> &jobs)
+{
+    char *text = M_LoadStringFromFile(path);
+    if(!text)
+    {
+        usermsg("G_RunDemoBatch: can't read list file '%s'\n", path);
+        return;
+    }
+
+    char *rover = text;
+    while(*rover)
+    {
+        char *line = rover;
+        while(*rover && *rover != '\n')
+            ++rover;
+        if(*rover)
+            *rover++ = '\0';
+
+        qstring entry(line);
+        entry.rstrip('\r').rstrip(' ').rstrip('\t').lstrip(' ').lstrip('\t');
+        if(entry.empty() || entry.charAt(0) == '#' || entry.charAt(0) == ';')
+            continue;
+
+        demojob_t &job = jobs.addNew();
+        if(entry.charAt(0) == '"')
+        {
+            size_t close = entry.find("\"", 1);
+            if(close == qstring::npos)
+                close = entry.length();
+            job.demo.copy(entry.constPtr() + 1, close - 1);
+            if(close < entry.length())
+                job.extra = entry.constPtr() + close + 1;
+        }
+        else
+        {
+            size_t space = entry.findFirstOf(' ');
+            if(space == qstring::npos)
+                space = entry.length();
+            job.demo.copy(entry.constPtr(), space);
+            if(space < entry.length())
+                job.extra = entry.constPtr() + space;
+        }
+    }
+
+    efree(text);
+}
+
+//
+// Reads back the -demolog written by a child and classifies the run
+//
+static void G_readDemoBatchLog(demojob_t &job)
+{
+    job.result   = DEMO_CRASH;
+    job.gametics = 0;
+
+    char *text = M_LoadStringFromFile(job.logpath.constPtr());
+    if(!text)
+        return;
+
+    // G_DemoLogEnd writes "<gametic>\tDemo end\t<exited|in level>\t..."
+    const char *end = nullptr;
+    for(const char *rover = strstr(text, "\tDemo end\t"); rover; rover = strstr(rover + 1, "\tDemo end\t"))
+        end = rover;
+    if(end)
+    {
+        const char *linestart = end;
+        while(linestart > text && linestart[-1] != '\n')
+            --linestart;
+        job.gametics = atoi(linestart);
+        job.result   = !strncmp(end + 10, "exited", 6) ? DEMO_PASS : DEMO_DESYNC;
+    }
+
+    efree(text);
+}
+
+//
+// Worker thread body. Picks the next pending job until none are left.
+//
+static void G_demoBatchWorker(Collection<demojob_t> *jobs, std::atomic<size_t> *next, std::mutex *printlock)
+{
+    size_t index;
+    while((index = next->fetch_add(1)) < jobs->getLength())
+    {
+        demojob_t &job = (*jobs)[index];
+
+        auto start  = std::chrono::steady_clock::now();
+        job.status  = system(job.command.constPtr());
+        job.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::lock_guard<std::mutex> lock(*printlock);
+        printf("[%u/%u] %s (%.2f s)\n", static_cast<unsigned>(index + 1), static_cast<unsigned>(jobs->getLength()),
+               job.demo.constPtr(), job.seconds);
+        fflush(stdout);
+    }
+}
+
+//
+// Describes how the child process terminated
+//
+static void G_describeStatus(int status, qstring &out)
+{
+#if EE_CURRENT_PLATFORM != EE_PLATFORM_WINDOWS
+    if(status != -1 && WIFSIGNALED(status))
+    {
+        out.Printf(0, "signal %d", WTERMSIG(status));
+        return;
+    }
+    if(status != -1 && WIFEXITED(status))
+        status = WEXITSTATUS(status);
+#endif
+    out.Printf(0, "exit %d", status);
+}
+
+//
+// True if -demobatch was given
+//
+bool G_DemoBatchRequested()
+{
+    return M_CheckParm("-demobatch") > 0;
+}
+
+//
+// Runs the whole batch and prints the summary. Returns the process exit code:
+// 0 if every demo passed, 1 otherwise.
+//
+int G_RunDemoBatch()
+{
+    int p = M_CheckParm("-demobatch");
+    if(!p || p >= myargc - 1)
+    {
+        usermsg("G_RunDemoBatch: usage: -demobatch <listfile|directory> [-batchjobs n] [-batchlogs dir] "
+                "[-batchcsv file]\n");
+        return 1;
+    }
+    const char *source = myargv[p + 1];
+
+    Collection<demojob_t> jobs;
+    std::error_code       ec;
+    if(fs::is_directory(source, ec))
+        G_addDemosFromDirectory(source, jobs);
+    else
+        G_addDemosFromList(source, jobs);
+
+    if(jobs.isEmpty())
+    {
+        usermsg("G_RunDemoBatch: no demos found in '%s'\n", source);
+        return 1;
+    }
+
+    int numjobs = static_cast<int>(emax(std::thread::hardware_concurrency(), 1u));
+    if((p = M_CheckParm("-batchjobs")) && p < myargc - 1)
+        numjobs = eclamp(atoi(myargv[p + 1]), 1, 256);
+    numjobs = emin(numjobs, static_cast<int>(jobs.getLength()));
+
+    qstring logdir("demobatch");
+    if((p = M_CheckParm("-batchlogs")) && p < myargc - 1)
+        logdir = myargv[p + 1];
+    logdir.normalizeSlashes();
+    if(!fs::is_directory(logdir.constPtr(), ec) && !I_CreateDirectory(logdir))
+    {
+        usermsg("G_RunDemoBatch: can't create log directory '%s'\n", logdir.constPtr());
+        return 1;
+    }
+
+    qstring forwarded;
+    G_buildForwardedArgs(forwarded);
+
+    for(size_t i = 0; i < jobs.getLength(); ++i)
+    {
+        demojob_t &job = jobs[i];
+        qstring    base;
+        job.demo.extractFileBase(base);
+
+        // prefix with the index, so demos with the same name in different
+        // directories of a list file don't clobber each other's logs
+        job.logpath = logdir;
+        job.logpath.pathConcatenate(qstring::Format("%04u_%s.log", static_cast<unsigned>(i), base.constPtr()));
+        job.outpath = logdir;
+        job.outpath.pathConcatenate(qstring::Format("%04u_%s.txt", static_cast<unsigned>(i), base.constPtr()));
+        remove(job.logpath.constPtr());
+
+        job.command.clear();
+        G_appendQuotedArg(job.command, myargv[0]);
+        job.command << forwarded;
+        if(!job.extra.empty())
+            job.command << " " << job.extra;
+        job.command << " -nodraw -noblit -nosound -fastdemo";
+        G_appendQuotedArg(job.command, job.demo.constPtr());
+        job.command << " -demolog";
+        G_appendQuotedArg(job.command, job.logpath.constPtr());
+        job.command << " >";
+        G_appendQuotedArg(job.command, job.outpath.constPtr());
+        job.command << " 2>&1";
+#if EE_CURRENT_PLATFORM == EE_PLATFORM_WINDOWS
+        // cmd.exe strips the outermost pair of quotes
+        job.command.insert("\"", 0);
+        job.command << "\"";
+#endif
+        job.status  = -1;
+        job.seconds = 0;
+    }
+
+    usermsg("Playing %u demos with %d worker processes...\n", static_cast<unsigned>(jobs.getLength()), numjobs);
+
+    auto                start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next(0);
+    std::mutex          printlock;
+    std::thread        *workers = new std::thread[numjobs];
+    for(int i = 0; i < numjobs; ++i)
+        workers[i] = std::thread(G_demoBatchWorker, &jobs, &next, &printlock);
+    for(int i = 0; i < numjobs; ++i)
+        workers[i].join();
+    delete[] workers;
+    double totaltime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    int counts[NUMDEMORESULTS] = {};
+
+    FILE *csv = nullptr;
+    if((p = M_CheckParm("-batchcsv")) && p < myargc - 1)
+    {
+        if((csv = I_fopen(myargv[p + 1], "wt")))
+            fputs("demo,result,status,gametics,seconds,tics_per_second\n", csv);
+        else
+            usermsg("G_RunDemoBatch: can't write '%s'\n", myargv[p + 1]);
+    }
+
+    usermsg("\n%-8s %-12s %10s %10s %12s  %s\n", "result", "status", "gametics", "seconds", "tics/sec", "demo");
+    for(demojob_t &job : jobs)
+    {
+        G_readDemoBatchLog(job);
+        ++counts[job.result];
+
+        qstring status;
+        G_describeStatus(job.status, status);
+        double rate = job.seconds > 0 ? job.gametics / job.seconds : 0;
+
+        usermsg("%-8s %-12s %10d %10.2f %12.1f  %s\n", resultnames[job.result], status.constPtr(), job.gametics,
+                job.seconds, rate, job.demo.constPtr());
+        if(csv)
+        {
+            qstring quoted(job.demo);
+            quoted.makeQuoted();
+            fprintf(csv, "%s,%s,%s,%d,%.3f,%.1f\n", quoted.constPtr(), resultnames[job.result], status.constPtr(),
+                    job.gametics, job.seconds, rate);
+        }
+    }
+    if(csv)
+        fclose(csv);
+
+    usermsg("\n%u demos: %d passed, %d desynced, %d crashed in %.2f s (logs in %s)\n",
+            static_cast<unsigned>(jobs.getLength()), counts[DEMO_PASS], counts[DEMO_DESYNC], counts[DEMO_CRASH],
+            totaltime, logdir.constPtr());
+
+    return counts[DEMO_PASS] == static_cast<int>(jobs.getLength()) ? 0 : 1;
+}
+
+// EOF
+
@@ -0,0 +1,36 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Headless batch demo runner.
+// Authors: Ioan Chera
+//
+
+#ifndef G_DEMOBATCH_H__
+#define G_DEMOBATCH_H__
+
+bool G_DemoBatchRequested();
+int  G_RunDemoBatch();
+
+#endif
+
+// EOF
+
@@ -107,6 +107,19 @@ void G_DemoLogSetExited(bool value)
     demoLogLevelExited = value;
 }
 
+//
+// Marks the end of the demo stream, telling whether the player was still in a
+// level at that moment (the -demobatch runner reads this back)
+//
+void G_DemoLogEnd()
+{
+    G_DemoLog("%d\tDemo end\t%s\t", gametic, demoLogLevelExited ? "exited" : "in level");
+    G_DemoLogStats();
+    G_DemoLog("\n");
+    if(demoLogFile)
+        fflush(demoLogFile);
+}
+
 //
 // True if demo logging is enabled.
 //
@@ -34,6 +34,7 @@ void G_DemoLog(E_FORMAT_STRING(const char *format), ...) E_PRINTF(1, 2);
 void G_DemoLogStats();
 bool G_DemoLogEnabled();
 void G_DemoLogSetExited(bool value);
+void G_DemoLogEnd();
 
 #endif
 
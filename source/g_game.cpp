@@ -51,6 +51,7 @@
 #include "g_demolog.h"
 #include "g_dmflag.h"
 #include "g_game.h"
+#include "g_rewind.h"
 #include "in_lude.h"
 #include "m_argv.h"
 #include "m_buffer.h"
@@ -1979,6 +1980,8 @@ void G_ForceFinale()
 
 static char *savename;
 
+static const PODCollection<byte> *loadbackup; // in-memory game to load instead
+
 //
 // killough 5/15/98: add forced loadgames, which allow user to override checks
 //
@@ -1999,6 +2002,7 @@ void G_LoadGame(const char *name, int slot, bool command)
 {
     if(savename)
         efree(savename);
+    loadbackup       = nullptr;
     savename         = estrdup(name);
     savegameslot     = slot;
     gameaction       = ga_loadgame;
@@ -2007,6 +2011,16 @@ void G_LoadGame(const char *name, int slot, bool command)
     hub_changelevel  = false;
 }
 
+//
+// Like G_LoadGame, but for a game saved to memory. The data must stay
+// around until the load happens.
+//
+void G_LoadGameFromMemory(const PODCollection<byte> &data)
+{
+    G_LoadGame("", 0, false);
+    loadbackup = &data;
+}
+
 // killough 5/15/98:
 // Consistency Error when attempting to load savegame.
 
@@ -2128,8 +2142,13 @@ WadDirectory *d_dir;
 
 static void G_DoLoadGame(void)
 {
+    const PODCollection<byte> *backup = loadbackup;
+
     gameaction = ga_nothing;
-    P_LoadGame(savename, nullptr);
+    loadbackup = nullptr;
+    if(!backup)
+        G_ClearRewind();
+    P_LoadGame(backup ? nullptr : savename, backup);
 }
 
 //
@@ -2222,6 +2241,12 @@ void G_Ticker()
         }
     }
 
+    // report screenshots and saves finished in the background
+    M_UpdateScreenShots();
+    P_UpdateSaveGames();
+
+    G_RewindTicker();
+
     if(animscreenshot) // animated screen shots
     {
         if(gametic % 16 == 0)
@@ -2990,6 +3015,7 @@ void G_DoNewGame()
     // G_StopDemo();
     G_ReloadDefaults(); // killough 3/1/98
     P_ClearHubs();      // sf: clear hubs when starting new game
+    G_ClearRewind();
 
     netgame  = false;           // killough 3/29/98
     GameType = DefaultGameType; // haleyjd  4/10/03
@@ -3717,6 +3743,9 @@ bool G_CheckDemoStatus()
         return false; // killough
     }
 
+    if(demoplayback)
+        G_DemoLogEnd();
+
     if(timingdemo)
     {
         int endtime = i_haltimer.GetRealTime();
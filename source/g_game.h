@@ -33,6 +33,9 @@ struct player_t;
 class Mobj;
 class WadDirectory;
 
+template<typename T>
+class PODCollection;
+
 //
 // GAME
 //
@@ -51,6 +54,7 @@ void     G_DeferedInitNewFromDir(skill_t skill, const char *levelname, WadDirect
 void     G_DeferedPlayDemo(const char *demo);
 void     G_TimeDemo(const char *name, bool showmenu);
 void     G_LoadGame(const char *name, int slot, bool is_command); // killough 5/15/98
+void     G_LoadGameFromMemory(const PODCollection<byte> &data);
 void     G_ForcedLoadGame();                                      // killough 5/15/98: forced loadgames
 void     G_LoadGameErr(const char *msg);
 void     G_SaveGame(int slot, const char *description); // Called by M_Responder.
@@ -0,0 +1,494 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Rewind buffer of in-memory level snapshots.
+//
+//  Every rewind_interval tics of play the level is saved to memory through
+//  P_SaveCurrentLevel. Only the newest snapshot is kept whole; each older one
+//  is stored as a deflated delta against the next newer one. The delta is a
+//  list of literal runs and copies out of the newer archive, found through a
+//  hash of its blocks, so data that merely moved (because a thinker before it
+//  was spawned or removed) still costs only a copy. Going back k snapshots
+//  undoes k deltas starting from the newest, and dropping the oldest snapshot
+//  when the ring is full needs no work at all.
+//
+// Authors: Ioan Chera
+//
+
+#include <chrono>
+
+#include "z_zone.h"
+
+#include "c_io.h"
+#include "c_runcmd.h"
+#include "d_event.h"
+#include "doomstat.h"
+#include "g_game.h"
+#include "g_rewind.h"
+#include "m_collection.h"
+#include "m_compare.h"
+#include "m_misc.h"
+#include "p_saveg.h"
+#include "v_misc.h"
+
+#include "../zlib/zlib.h"
+
+static constexpr int MAXREWINDSNAPSHOTS = 300;
+
+int rewind_interval  = 0;
+int rewind_snapshots = 30;
+
+//
+// An older snapshot, kept as a delta against the next newer one
+//
+struct rewindsnap_t
+{
+    byte  *delta;     // deflated delta against the next newer archive
+    size_t deltasize; // deflated size
+    size_t opsize;    // inflated size of the delta
+    size_t rawsize;   // length of this snapshot's archive
+    int    leveltime;
+    char   mapname[9];
+};
+
+static rewindsnap_t rewind_ring[MAXREWINDSNAPSHOTS]; // oldest first from rewind_head
+static int          rewind_head, rewind_count;
+
+// newest snapshot, whole
+static PODCollection<byte> rewind_newest;
+static int                 rewind_newesttime;
+static char                rewind_newestmap[9];
+static bool                rewind_hasnewest;
+
+static int rewind_lastsnaptime = -1;
+
+// the snapshot being restored, kept until the load happens
+static PODCollection<byte> rewind_loadbuffer;
+
+// Throughput statistics
+static struct rewindstats_t
+{
+    int      snapshots;
+    int64_t  saveus, deltaus; // time spent archiving and delta-encoding
+    uint64_t rawbytes;
+    uint64_t deltarawbytes, deltabytes; // archives turned into deltas, and what they became
+    size_t   lastraw, lastdelta;        // the most recent of those
+} rewind_stats;
+
+//=============================================================================
+//
+// Delta Encoding
+//
+// A delta rebuilds the older archive from the newer one. It is a sequence of
+//   literal length, literal bytes, copy offset, copy length
+// repeated until the older archive is complete, all numbers as varints. Copy
+// offsets are stored relative to the end of the previous copy, zigzagged.
+//
+
+static constexpr size_t   DELTABLOCK   = 32;         // bytes per indexed block of the newer archive
+static constexpr size_t   DELTAMINRUN  = 8;          // shortest run tried at the previous copy's shift
+static constexpr uint32_t DELTAHASHMUL = 0x01000193; // rolling hash multiplier
+
+//
+// Hashes DELTABLOCK bytes
+//
+static uint32_t G_deltaHash(const byte *data)
+{
+    uint32_t h = 0;
+    for(size_t i = 0; i < DELTABLOCK; i++)
+        h = h * DELTAHASHMUL + data[i];
+    return h;
+}
+
+static void G_putVarint(PODCollection<byte> &out, uint64_t v)
+{
+    for(; v >= 0x80; v >>= 7)
+        out.add(byte(v | 0x80));
+    out.add(byte(v));
+}
+
+static bool G_getVarint(const byte *&in, const byte *end, uint64_t &v)
+{
+    v = 0;
+    for(int shift = 0; in < end && shift < 64; shift += 7)
+    {
+        const byte b  = *in++;
+        v            |= uint64_t(b & 0x7f) << shift;
+        if(!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+//
+// Builds the delta that turns newer back into older
+//
+static void G_encodeDelta(const byte *older, size_t oldsize, const byte *newer, size_t newsize,
+                          PODCollection<byte> &ops)
+{
+    // Index the newer archive's aligned blocks. Later blocks overwrite earlier
+    // ones on collision; that only costs a missed match.
+    const size_t numblocks = newsize / DELTABLOCK;
+    size_t       tablesize = 1;
+    while(tablesize < numblocks * 2)
+        tablesize <<= 1;
+    const size_t mask = tablesize - 1;
+
+    PODCollection<uint32_t> table; // block offset + 1, 0 for none
+    table.resize(tablesize);
+    for(size_t i = 0; i < numblocks; i++)
+        table[G_deltaHash(newer + i * DELTABLOCK) & mask] = uint32_t(i * DELTABLOCK + 1);
+
+    // multiplier of the byte leaving the rolling hash
+    uint32_t outmul = 1;
+    for(size_t i = 1; i < DELTABLOCK; i++)
+        outmul *= DELTAHASHMUL;
+
+    size_t    pos = 0, literal = 0, prevend = 0;
+    ptrdiff_t shift = 0; // newer offset minus older offset of the last copy
+    uint32_t  hash  = 0;
+    bool      hashvalid = false;
+
+    while(pos + DELTAMINRUN <= oldsize)
+    {
+        size_t match = SIZE_MAX;
+
+        // Most changes are values overwritten in place, so first try to carry
+        // on where the last copy left off.
+        const ptrdiff_t expect = ptrdiff_t(pos) + shift;
+        if(expect >= 0 && size_t(expect) + DELTAMINRUN <= newsize &&
+           !memcmp(older + pos, newer + expect, DELTAMINRUN))
+        {
+            match = size_t(expect);
+        }
+        else if(pos + DELTABLOCK <= oldsize)
+        {
+            if(!hashvalid)
+            {
+                hash      = G_deltaHash(older + pos);
+                hashvalid = true;
+            }
+            const uint32_t entry = table[hash & mask];
+            if(entry && !memcmp(older + pos, newer + entry - 1, DELTABLOCK))
+                match = entry - 1;
+        }
+
+        if(match == SIZE_MAX)
+        {
+            if(hashvalid && pos + DELTABLOCK < oldsize)
+                hash = (hash - older[pos] * outmul) * DELTAHASHMUL + older[pos + DELTABLOCK];
+            else
+                hashvalid = false;
+            ++pos;
+            continue;
+        }
+
+        // grow the match back into the pending literal, then forward
+        while(pos > literal && match > 0 && older[pos - 1] == newer[match - 1])
+            --pos, --match;
+        size_t length = 0;
+        while(pos + length < oldsize && match + length < newsize && older[pos + length] == newer[match + length])
+            ++length;
+
+        G_putVarint(ops, pos - literal);
+        for(size_t i = literal; i < pos; i++)
+            ops.add(older[i]);
+
+        const int64_t offset = int64_t(match) - int64_t(prevend);
+        G_putVarint(ops, (uint64_t(offset) << 1) ^ uint64_t(offset >> 63));
+        G_putVarint(ops, length);
+
+        shift     = ptrdiff_t(match) - ptrdiff_t(pos);
+        prevend   = match + length;
+        pos      += length;
+        literal   = pos;
+        hashvalid = false;
+    }
+
+    // whatever is left is literal
+    G_putVarint(ops, oldsize - literal);
+    for(size_t i = literal; i < oldsize; i++)
+        ops.add(older[i]);
+}
+
+//
+// Rebuilds the older archive from newer and a delta. Returns false if the
+// delta doesn't fit.
+//
+static bool G_decodeDelta(const byte *ops, size_t opsize, const byte *newer, size_t newsize, byte *out,
+                          size_t rawsize)
+{
+    const byte *const opsend  = ops + opsize;
+    size_t            pos     = 0;
+    uint64_t          prevend = 0;
+
+    for(;;)
+    {
+        uint64_t length;
+        if(!G_getVarint(ops, opsend, length) || length > rawsize - pos || length > size_t(opsend - ops))
+            return false;
+        memcpy(out + pos, ops, length);
+        ops += length;
+        pos += length;
+
+        if(pos == rawsize)
+            return ops == opsend;
+
+        uint64_t zigzag;
+        if(!G_getVarint(ops, opsend, zigzag) || !G_getVarint(ops, opsend, length))
+            return false;
+
+        const uint64_t match = prevend + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+        if(match > newsize || length > newsize - match || length > rawsize - pos)
+            return false;
+        memcpy(out + pos, newer + match, length);
+        pos     += length;
+        prevend  = match + length;
+    }
+}
+
+//
+// Frees a ring entry
+//
+static void G_freeSnap(rewindsnap_t &snap)
+{
+    if(snap.delta)
+        efree(snap.delta);
+    snap = {};
+}
+
+//
+// Drops every snapshot
+//
+void G_ClearRewind()
+{
+    for(int i = 0; i < rewind_count; i++)
+        G_freeSnap(rewind_ring[(rewind_head + i) % MAXREWINDSNAPSHOTS]);
+    rewind_head = rewind_count = 0;
+
+    rewind_newest.clear();
+    rewind_hasnewest    = false;
+    rewind_lastsnaptime = -1;
+}
+
+//
+// Turns the current newest snapshot into a delta against the new one
+//
+static void G_pushDelta(const PODCollection<byte> &newer)
+{
+    const size_t oldsize = rewind_newest.getLength();
+
+    PODCollection<byte> ops;
+    G_encodeDelta(&rewind_newest[0], oldsize, &newer[0], newer.getLength(), ops);
+
+    const size_t opsize = ops.getLength();
+    uLongf       zsize  = compressBound(uLong(opsize));
+    byte        *zdata  = emalloc(byte *, zsize);
+    if(compress2(zdata, &zsize, &ops[0], uLong(opsize), Z_BEST_SPEED) != Z_OK)
+    {
+        // can't go back past here
+        efree(zdata);
+        G_ClearRewind();
+        return;
+    }
+
+    if(rewind_count == emin(rewind_snapshots, MAXREWINDSNAPSHOTS))
+    {
+        G_freeSnap(rewind_ring[rewind_head]);
+        rewind_head = (rewind_head + 1) % MAXREWINDSNAPSHOTS;
+        --rewind_count;
+    }
+
+    rewindsnap_t &snap = rewind_ring[(rewind_head + rewind_count++) % MAXREWINDSNAPSHOTS];
+    snap.delta         = erealloc(byte *, zdata, zsize);
+    snap.deltasize     = zsize;
+    snap.opsize        = opsize;
+    snap.rawsize       = oldsize;
+    snap.leveltime     = rewind_newesttime;
+    memcpy(snap.mapname, rewind_newestmap, sizeof(snap.mapname));
+
+    rewind_stats.deltarawbytes += oldsize;
+    rewind_stats.deltabytes    += zsize;
+    rewind_stats.lastraw        = oldsize;
+    rewind_stats.lastdelta      = zsize;
+}
+
+//
+// Takes a snapshot every rewind_interval tics of play. Called from G_Ticker
+// between tics.
+//
+void G_RewindTicker()
+{
+    if(rewind_interval <= 0 || gamestate != GS_LEVEL || gameaction != ga_nothing || netgame || demoplayback ||
+       demorecording || !leveltime || leveltime == rewind_lastsnaptime || leveltime % rewind_interval)
+    {
+        return;
+    }
+
+    static char desc[] = "rewind";
+
+    using clock = std::chrono::steady_clock;
+
+    const auto          start = clock::now();
+    PODCollection<byte> snapshot;
+    P_SaveCurrentLevel(nullptr, desc, &snapshot);
+    const auto saved = clock::now();
+
+    if(snapshot.isEmpty())
+        return;
+
+    if(rewind_hasnewest)
+        G_pushDelta(snapshot);
+
+    rewind_newest     = std::move(snapshot);
+    rewind_newesttime = leveltime;
+    strncpy(rewind_newestmap, gamemapname, 8);
+    rewind_newestmap[8] = '\0';
+    rewind_hasnewest    = true;
+    rewind_lastsnaptime = leveltime;
+
+    const auto done = clock::now();
+
+    ++rewind_stats.snapshots;
+    rewind_stats.saveus   += std::chrono::duration_cast<std::chrono::microseconds>(saved - start).count();
+    rewind_stats.deltaus  += std::chrono::duration_cast<std::chrono::microseconds>(done - saved).count();
+    rewind_stats.rawbytes += rewind_newest.getLength();
+}
+
+//
+// Restores the snapshot back steps from the newest (0 being the newest) and
+// drops everything newer than it.
+//
+static bool G_restoreSnapshot(int back)
+{
+    if(!rewind_hasnewest || back < 0 || back > rewind_count)
+        return false;
+
+    for(int i = 0; i < back; i++)
+    {
+        rewindsnap_t &snap = rewind_ring[(rewind_head + rewind_count - 1) % MAXREWINDSNAPSHOTS];
+
+        PODCollection<byte> ops, older;
+        uLongf              opsize = uLong(snap.opsize);
+        ops.resize(snap.opsize);
+        older.resize(snap.rawsize);
+        if(uncompress(&ops[0], &opsize, snap.delta, uLong(snap.deltasize)) != Z_OK || opsize != snap.opsize ||
+           !G_decodeDelta(&ops[0], opsize, &rewind_newest[0], rewind_newest.getLength(), &older[0], snap.rawsize))
+        {
+            G_ClearRewind();
+            return false;
+        }
+
+        rewind_newest     = std::move(older);
+        rewind_newesttime = snap.leveltime;
+        memcpy(rewind_newestmap, snap.mapname, sizeof(rewind_newestmap));
+
+        G_freeSnap(snap);
+        --rewind_count;
+    }
+
+    rewind_loadbuffer.resize(rewind_newest.getLength());
+    memcpy(&rewind_loadbuffer[0], &rewind_newest[0], rewind_newest.getLength());
+    G_LoadGameFromMemory(rewind_loadbuffer);
+
+    // don't snapshot again right where we land
+    rewind_lastsnaptime = rewind_newesttime;
+    return true;
+}
+
+//=============================================================================
+//
+// Console Commands
+//
+
+VARIABLE_INT(rewind_interval, nullptr, 0, 35 * 60, nullptr);
+CONSOLE_VARIABLE(rewind_interval, rewind_interval, 0)
+{
+    if(rewind_interval <= 0)
+        G_ClearRewind();
+}
+
+VARIABLE_INT(rewind_snapshots, nullptr, 1, MAXREWINDSNAPSHOTS, nullptr);
+CONSOLE_VARIABLE(rewind_snapshots, rewind_snapshots, 0)
+{
+    // drop the oldest ones now over the limit
+    while(rewind_count > rewind_snapshots)
+    {
+        G_freeSnap(rewind_ring[rewind_head]);
+        rewind_head = (rewind_head + 1) % MAXREWINDSNAPSHOTS;
+        --rewind_count;
+    }
+}
+
+CONSOLE_COMMAND(rewind, cf_notnet)
+{
+    if(demoplayback || demorecording)
+    {
+        C_Printf(FC_ERROR "Can't rewind during demos\n");
+        return;
+    }
+
+    const int back = Console.argc ? Console.argv[0]->toInt() : 1;
+    if(back < 1)
+    {
+        C_Printf("usage: rewind [snapshots] (1 for the latest, up to %d)\n", rewind_count + rewind_hasnewest);
+        return;
+    }
+
+    if(!G_restoreSnapshot(back - 1))
+    {
+        C_Printf(FC_ERROR "No snapshot that far back (%d kept)\n", rewind_count + rewind_hasnewest);
+        return;
+    }
+
+    C_Printf("Rewound to %s at %d:%02d\n", rewind_newestmap, rewind_newesttime / (TICRATE * 60),
+             (rewind_newesttime / TICRATE) % 60);
+}
+
+CONSOLE_COMMAND(rewind_stats, 0)
+{
+    const rewindstats_t &s = rewind_stats;
+    if(!s.snapshots)
+    {
+        C_Printf("No snapshots taken\n");
+        return;
+    }
+
+    size_t held = rewind_newest.getLength();
+    for(int i = 0; i < rewind_count; i++)
+        held += rewind_ring[(rewind_head + i) % MAXREWINDSNAPSHOTS].deltasize;
+
+    const double saveus  = double(s.saveus) / s.snapshots;
+    const double deltaus = double(s.deltaus) / s.snapshots;
+    const double rawkb   = double(s.rawbytes) / s.snapshots / 1024.0;
+
+    C_Printf("%d snapshots taken, %d kept, %zu KB held\n"
+             "archive: %.1f KB in %.2f ms (%.1f MB/s)\n"
+             "delta: %.2f ms, %.2f%% of archive size (last %zu of %zu bytes)\n",
+             s.snapshots, rewind_count + rewind_hasnewest, held / 1024, rawkb, saveus / 1000.0,
+             saveus > 0 ? rawkb / 1024.0 / (saveus / 1000000.0) : 0.0, deltaus / 1000.0,
+             s.deltarawbytes ? 100.0 * double(s.deltabytes) / double(s.deltarawbytes) : 0.0, s.lastdelta,
+             s.lastraw);
+}
+
+// EOF
+
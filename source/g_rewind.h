@@ -0,0 +1,39 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Rewind buffer of in-memory level snapshots.
+// Authors: Ioan Chera
+//
+
+#ifndef G_REWIND_H__
+#define G_REWIND_H__
+
+extern int rewind_interval;  // tics between snapshots, 0 to disable
+extern int rewind_snapshots; // snapshots kept
+
+void G_RewindTicker();
+void G_ClearRewind();
+
+#endif
+
+// EOF
+
@@ -28,6 +28,7 @@
 #include "hal/i_directory.h"
 #include "i_system.h"
 #include "m_buffer.h"
+#include "m_compare.h"
 #include "m_swap.h"
 
 //=============================================================================
@@ -313,59 +314,73 @@ bool OutBuffer::writeSint8(int8_t num)
 //
 // OutMemoryBuffer
 //
+//
+// Makes room for size more bytes and returns where they go. The storage grows
+// geometrically, so the collection's length runs ahead of the data written and
+// is trimmed by takeData.
+//
+byte *OutMemoryBuffer::reserve(size_t size)
+{
+    const size_t needed = _length + size;
+    if(needed > _data.getLength())
+        _data.resize(emax(needed, _data.getLength() * 2));
+
+    byte *dest = &_data[_length];
+    _length    = needed;
+    return dest;
+}
 bool OutMemoryBuffer::write(const void *data, size_t size)
 {
-    auto bdata = static_cast<const byte *>(data);
-    for(size_t i = 0; i < size; ++i)
-        _data.add(bdata[i]);
+    if(size)
+        memcpy(reserve(size), data, size);
     return true;
 }
 bool OutMemoryBuffer::writeSint64(int64_t num)
 {
-    _data.resize(_data.getLength() + 8);
-    memcpy(&_data[_data.getLength() - 8], &num, 8);
+    memcpy(reserve(8), &num, 8);
     return true;
 }
 bool OutMemoryBuffer::writeUint64(uint64_t num)
 {
-    _data.resize(_data.getLength() + 8);
-    memcpy(&_data[_data.getLength() - 8], &num, 8);
+    memcpy(reserve(8), &num, 8);
     return true;
 }
 bool OutMemoryBuffer::writeSint32(int32_t num)
 {
-    _data.resize(_data.getLength() + 4);
-    memcpy(&_data[_data.getLength() - 4], &num, 4);
+    memcpy(reserve(4), &num, 4);
     return true;
 }
 bool OutMemoryBuffer::writeUint32(uint32_t num)
 {
-    _data.resize(_data.getLength() + 4);
-    memcpy(&_data[_data.getLength() - 4], &num, 4);
+    memcpy(reserve(4), &num, 4);
     return true;
 }
 bool OutMemoryBuffer::writeSint16(int16_t num)
 {
-    _data.resize(_data.getLength() + 2);
-    memcpy(&_data[_data.getLength() - 2], &num, 2);
+    memcpy(reserve(2), &num, 2);
     return true;
 }
 bool OutMemoryBuffer::writeUint16(uint16_t num)
 {
-    _data.resize(_data.getLength() + 2);
-    memcpy(&_data[_data.getLength() - 2], &num, 2);
+    memcpy(reserve(2), &num, 2);
     return true;
 }
 bool OutMemoryBuffer::writeSint8(int8_t num)
 {
-    _data.add((byte)num);
+    *reserve(1) = (byte)num;
     return true;
 }
 bool OutMemoryBuffer::writeUint8(uint8_t num)
 {
-    _data.add((byte)num);
+    *reserve(1) = (byte)num;
     return true;
 }
+PODCollection<byte> OutMemoryBuffer::takeData()
+{
+    _data.resize(_length);
+    _length = 0;
+    return std::move(_data);
+}
 
 //=============================================================================
 //
@@ -152,10 +152,14 @@ public:
     bool writeSint8(int8_t num) override;
     bool writeUint8(uint8_t num) override;
 
-    PODCollection<byte> takeData() { return std::move(_data); }
+    size_t              getLength() const { return _length; }
+    PODCollection<byte> takeData();
 
 private:
+    byte *reserve(size_t size);
+
     PODCollection<byte> _data;
+    size_t              _length = 0; // bytes written
 };
 
 class IInBuffer
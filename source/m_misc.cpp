@@ -46,6 +46,7 @@
 #include "doomstat.h"
 #include "f_wipe.h"
 #include "g_game.h"
+#include "g_rewind.h"
 #include "hu_over.h"
 #include "hu_stuff.h"
 #include "i_sound.h"
@@ -120,6 +121,10 @@ extern int adlmidi_emulator;
 const int BANKS_MAX = (adl_getBanksCount() - 1);
 #endif
 
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+extern int snd_musicbuffer;
+#endif
+
 // haleyjd 10/09/07: wipe waiting
 extern int wipewait;
 
@@ -193,6 +198,12 @@ default_t defaults[] = {
     DEFAULT_INT("demo_insurance", &default_demo_insurance, nullptr, 2, 0, 2, default_t::wad_no,
                 "1=take special steps ensuring demo sync, 2=only during recordings"),
 
+    DEFAULT_INT("rewind_interval", &rewind_interval, nullptr, 0, 0, 35 * 60, default_t::wad_no,
+                "Tics between rewind snapshots (0 = rewind disabled)"),
+
+    DEFAULT_INT("rewind_snapshots", &rewind_snapshots, nullptr, 30, 1, 300, default_t::wad_no,
+                "Number of rewind snapshots kept"),
+
     // phares
     DEFAULT_INT("weapon_recoil", &default_weapon_recoil, &weapon_recoil, 0, 0, 1, default_t::wad_game,
                 "1 to enable recoil from weapon fire"),
@@ -871,6 +882,11 @@ default_t defaults[] = {
                 "sound bank used for ADLMIDI"),
 #endif
 
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+    DEFAULT_INT("snd_musicbuffer", &snd_musicbuffer, nullptr, 100, 20, 2000, default_t::wad_no,
+                "milliseconds of SPC or ADLMIDI music rendered ahead of playback"),
+#endif
+
 #ifdef _WIN32
     DEFAULT_INT("winmm_reset_type", &winmm_reset_type, nullptr, RESET_TYPE_DEFAULT, RESET_TYPE_DEFAULT, RESET_TYPE_XG,
                 default_t::wad_no,
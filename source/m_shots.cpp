@@ -21,13 +21,20 @@
 // Authors: James Haley, Max Waine
 //
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "z_zone.h"
 
 #include "autopalette.h"
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "d_gi.h"
 #include "d_io.h"
 #include "doomstat.h"
+#include "i_system.h"
 #include "m_buffer.h"
 #include "m_qstr.h"
 #include "m_utils.h"
@@ -92,11 +99,9 @@ struct pcx_t
 //
 // pcx_Writer
 //
-static bool pcx_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette)
+static bool pcx_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette, char *, size_t)
 {
-    unsigned int i;
-    pcx_t        pcx;
-    byte         temppal[768], *palptr;
+    pcx_t pcx;
 
     // Setup PCX Header
     // haleyjd 09/27/07: Changed pcx.palette_type from 2 to 1.
@@ -159,22 +164,7 @@ static bool pcx_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
 
     // Write the palette
     SafeWrite8(ob, 0x0c); // palette ID byte
-
-    // haleyjd 11/16/04: make gamma correction optional
-    if(screenshot_gamma)
-    {
-        for(i = 0; i < 768; i += 3)
-        {
-            temppal[i + 0] = gammatable[usegamma][palette[i + 0]]; // killough
-            temppal[i + 1] = gammatable[usegamma][palette[i + 1]];
-            temppal[i + 2] = gammatable[usegamma][palette[i + 2]];
-        }
-        palptr = temppal;
-    }
-    else
-        palptr = palette;
-
-    SafeWrite(ob, palptr, 768);
+    SafeWrite(ob, palette, 768);
 
     // Done!
     return true;
@@ -222,7 +212,7 @@ struct BITMAPINFOHEADER
 //
 // jff 3/30/98 Add capability to write a .BMP file (256 color uncompressed)
 //
-static bool bmp_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette)
+static bool bmp_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette, char *, size_t)
 {
     unsigned int     i, j, wid;
     BITMAPFILEHEADER bmfh;
@@ -274,27 +264,13 @@ static bool bmp_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
     SafeWrite32(ob, bmih.biClrUsed);
     SafeWrite32(ob, bmih.biClrImportant);
 
-    // haleyjd 11/16/04: make gamma correction optional
-    if(screenshot_gamma)
+    // write the palette, in blue-green-red order
+    for(i = j = 0; i < 768; i += 3, j += 4)
     {
-        // write the palette, in blue-green-red order, gamma corrected
-        for(i = j = 0; i < 768; i += 3, j += 4)
-        {
-            temppal[j + 0] = gammatable[usegamma][palette[i + 2]];
-            temppal[j + 1] = gammatable[usegamma][palette[i + 1]];
-            temppal[j + 2] = gammatable[usegamma][palette[i + 0]];
-            temppal[j + 3] = 0;
-        }
-    }
-    else
-    {
-        for(i = j = 0; i < 768; i += 3, j += 4)
-        {
-            temppal[j + 0] = palette[i + 2];
-            temppal[j + 1] = palette[i + 1];
-            temppal[j + 2] = palette[i + 0];
-            temppal[j + 3] = 0;
-        }
+        temppal[j + 0] = palette[i + 2];
+        temppal[j + 1] = palette[i + 1];
+        temppal[j + 2] = palette[i + 0];
+        temppal[j + 3] = 0;
     }
     SafeWrite(ob, temppal, 1024);
 
@@ -336,7 +312,7 @@ struct tgaheader_t
 //
 // haleyjd 12/28/09
 //
-static bool tga_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette)
+static bool tga_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette, char *, size_t)
 {
     tgaheader_t  tga;
     unsigned int i;
@@ -374,23 +350,11 @@ static bool tga_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
     // clang-format on
 
     // Write colormap
-    if(screenshot_gamma)
+    for(i = 0; i < 768; i += 3)
     {
-        for(i = 0; i < 768; i += 3)
-        {
-            temppal[i + 0] = gammatable[usegamma][palette[i + 2]];
-            temppal[i + 1] = gammatable[usegamma][palette[i + 1]];
-            temppal[i + 2] = gammatable[usegamma][palette[i + 0]];
-        }
-    }
-    else
-    {
-        for(i = 0; i < 768; i += 3)
-        {
-            temppal[i + 0] = palette[i + 2];
-            temppal[i + 1] = palette[i + 1];
-            temppal[i + 2] = palette[i + 0];
-        }
+        temppal[i + 0] = palette[i + 2];
+        temppal[i + 1] = palette[i + 1];
+        temppal[i + 2] = palette[i + 0];
     }
     SafeWrite(ob, temppal, 768);
 
@@ -415,6 +379,8 @@ struct pngiodata_t
 {
     OutBuffer *ob;      // OutBuffer to call Write on.
     bool       writeOK; // Tracks if a write error has occurred.
+    char      *errmsg;  // First libpng error, reported by the main thread.
+    size_t     errlen;
 };
 
 //
@@ -446,7 +412,11 @@ static void PNG_dataFlush(png_structp png_ptr)
 //
 static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 {
-    C_Printf(FC_ERROR "libpng error: %s\a", error_msg);
+    pngiodata_t *pngIoData = static_cast<pngiodata_t *>(png_get_error_ptr(png_ptr));
+
+    // runs on the screenshot thread; leave the printing to the main thread
+    if(pngIoData->errmsg && !*pngIoData->errmsg)
+        psnprintf(pngIoData->errmsg, pngIoData->errlen, "libpng error: %s", error_msg);
 
     throw 0;
 }
@@ -458,7 +428,6 @@ static void PNG_handleError(png_structp png_ptr, png_const_charp error_msg)
 //
 static void PNG_handleWarning(png_structp png_ptr, png_const_charp error_msg)
 {
-    C_Printf(FC_ERROR "libpng warning: %s", error_msg);
 }
 
 //
@@ -469,7 +438,8 @@ static void PNG_handleWarning(png_structp png_ptr, png_const_charp error_msg)
 // Some code derived from WadGen, copyright 2011 Samuel 'Kaiser' Villarreal
 // Used under GPLv2.0 or later.
 //
-static bool png_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette)
+static bool png_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t height, byte *palette, char *errmsg,
+                       size_t errlen)
 {
     png_structp pngStruct;
     png_infop   pngInfo;
@@ -478,6 +448,8 @@ static bool png_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
 
     pngIoData.ob      = ob;
     pngIoData.writeOK = true;
+    pngIoData.errmsg  = errmsg;
+    pngIoData.errlen  = errlen;
 
     byte *row_pointer;
 
@@ -507,23 +479,11 @@ static bool png_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
                      PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
 
         // setup palette
-        if(screenshot_gamma)
-        {
-            for(int i = 0; i < 256; i++)
-            {
-                pngPalette[i].red   = gammatable[usegamma][palette[i * 3 + 0]];
-                pngPalette[i].green = gammatable[usegamma][palette[i * 3 + 1]];
-                pngPalette[i].blue  = gammatable[usegamma][palette[i * 3 + 2]];
-            }
-        }
-        else
+        for(int i = 0; i < 256; i++)
         {
-            for(int i = 0; i < 256; i++)
-            {
-                pngPalette[i].red   = palette[i * 3 + 0];
-                pngPalette[i].green = palette[i * 3 + 1];
-                pngPalette[i].blue  = palette[i * 3 + 2];
-            }
+            pngPalette[i].red   = palette[i * 3 + 0];
+            pngPalette[i].green = palette[i * 3 + 1];
+            pngPalette[i].blue  = palette[i * 3 + 2];
         }
         // add palette to png
         png_set_PLTE(pngStruct, pngInfo, pngPalette, 256);
@@ -566,7 +526,8 @@ static bool png_Writer(OutBuffer *ob, byte *data, uint32_t width, uint32_t heigh
 // Shared Code
 //
 
-using ShotWriter_t = bool (*)(OutBuffer *, byte *, uint32_t, uint32_t, byte *);
+// The last two parameters take the text of an encoder error, if there is one.
+using ShotWriter_t = bool (*)(OutBuffer *, byte *, uint32_t, uint32_t, byte *, char *, size_t);
 
 struct shotformat_t
 {
@@ -591,22 +552,93 @@ static shotformat_t shotFormats[SHOT_NUMSHOTFORMATS] = {
     { "png", OutBuffer::NENDIAN, png_Writer }, // Portable Network Graphics
 };
 
+//=============================================================================
 //
-// M_ScreenShot
+// Background Writer
 //
-// Modified by Lee Killough so that any number of shots can be taken,
-// the code is faster, and no annoying "screenshot" message appears.
+// Frames are copied on the main thread and handed to a single writer thread,
+// which encodes them and writes them out. Results come back through a second
+// queue and are reported by M_UpdateScreenShots on the main thread, since
+// neither the console nor the sound code may be touched from the writer.
 //
-// killough 10/98: improved error-handling
+
+static constexpr int SHOTQUEUESIZE = 8; // frames that may be waiting at once
+
+struct shotjob_t
+{
+    OutBuffer           ob; // file, created on the main thread
+    char                filename[PATH_MAX + 1];
+    byte               *data; // copied, transposed frame
+    uint32_t            width, height;
+    byte                palette[768]; // gamma applied if wanted
+    const shotformat_t *format;
+    bool                quiet; // frame dump: no sound per frame
+
+    // results
+    bool success;
+    int  error; // errno from the writer thread
+    char errmsg[256];
+};
+
+static std::mutex              shotmutex;
+static std::condition_variable shotcv;
+static bool                    shotthreadstarted; // writer is started once and runs until exit
+static shotjob_t              *pendingshots[SHOTQUEUESIZE];
+static int                     pendinghead, pendingcount;
+static shotjob_t              *finishedshots[SHOTQUEUESIZE];
+static int                     finishedcount;
+static int                     shotsinflight; // queued, being written, or awaiting report
+
+// Frame dump state
+static int framedumpleft;    // frames still to capture, -1 for no limit
+static int framedumpdropped; // frames skipped because the queue was full
+
 //
-void M_ScreenShot()
+// Writer thread loop
+//
+static void M_shotThreadFunc()
 {
-    bool          success = false;
-    qstring       path;
-    OutBuffer     ob;
-    shotformat_t *format = &shotFormats[screenshot_pcx];
+    for(;;)
+    {
+        shotjob_t *job;
+        {
+            std::unique_lock lock(shotmutex);
+            shotcv.wait(lock, [] { return pendingcount > 0; });
+            job         = pendingshots[pendinghead];
+            pendinghead = (pendinghead + 1) % SHOTQUEUESIZE;
+            --pendingcount;
+        }
 
-    errno = 0;
+        errno = 0;
+
+        // killough 10/98: detect failure and remove file if error
+        job->success = job->format->writer(&job->ob, job->data, job->width, job->height, job->palette, job->errmsg,
+                                           sizeof(job->errmsg));
+
+        // haleyjd: close the buffer
+        job->ob.close();
+
+        job->error = errno;
+
+        // if not successful, remove the file now
+        if(!job->success)
+            remove(job->filename);
+
+        efree(job->data);
+        job->data = nullptr;
+
+        std::lock_guard lock(shotmutex);
+        finishedshots[finishedcount++] = job;
+    }
+}
+
+//
+// Finds a free file name and opens the file, so that queued shots don't race
+// each other for the same name. Returns false on failure, with errno set.
+//
+static bool M_openShotFile(shotjob_t &job)
+{
+    qstring path;
 
     // haleyjd 11/23/06: use userpath/shots
     path = userpath;
@@ -616,64 +648,202 @@ void M_ScreenShot()
     // constants rather than integers, some of which were not even
     // correct under DJGPP to begin with (it's a wonder it worked...)
 
-    if(!access(path.constPtr(), W_OK))
+    if(access(path.constPtr(), W_OK))
+        return false;
+
+    static int shot;
+    int        tries = 10000;
+
+    do
     {
-        static int shot;
-        char      *lbmname = nullptr;
-        int        tries   = 10000;
+        // jff 3/30/98 pcx or bmp?
+        // haleyjd: use format extension.
+        psnprintf(job.filename, sizeof(job.filename), "%s/etrn%02d.%s", path.constPtr(), shot++,
+                  job.format->extension);
+    }
+    while(!access(job.filename, F_OK) && --tries);
 
-        size_t len = M_StringAlloca(&lbmname, 2, 16, path.constPtr(), format->extension);
+    return tries && job.ob.createFile(job.filename, 512 * 1024, job.format->endian);
+}
 
-        do
-        {
-            // jff 3/30/98 pcx or bmp?
-            // haleyjd: use format extension.
-            psnprintf(lbmname, len, "%s/etrn%02d.%s", path.constPtr(), shot++, format->extension);
-        }
-        while(!access(lbmname, F_OK) && --tries);
+//
+// Reports a finished or failed shot
+//
+static void M_reportShot(bool success, int error, const char *errmsg, bool quiet)
+{
+    // 1/18/98 killough: replace "SCREEN SHOT" acknowledgement with sfx
+    // players[consoleplayer].message = "screen shot"
 
-        if(tries && ob.createFile(lbmname, 512 * 1024, format->endian))
-        {
-            // killough 4/18/98: make palette stay around
-            // (PU_CACHE could cause crash)
-            // byte *pal = (byte *)wGlobalDir.cacheLumpName("PLAYPAL", PU_STATIC);
-            AutoPalette pal(wGlobalDir);
+    // killough 10/98: print error message and change sound effect if error
+    if(!success)
+    {
+        if(*errmsg)
+            C_Printf(FC_ERROR "%s\a", errmsg);
+        doom_printf("%s", error ? strerror(error) : FC_ERROR "Could not take screenshot");
+        S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
+    }
+    else if(!quiet)
+        S_StartInterfaceSound(GameModeInfo->c_BellSound);
+}
 
-            // get screen graphics
-            V_BlitVBuffer(&backscreen2, 0, 0, &vbscreen, 0, 0, vbscreen.width, vbscreen.height);
+static void M_FlushScreenShots();
 
-            // killough 10/98: detect failure and remove file if error
-            success = format->writer(&ob, backscreen2.data, (uint32_t)(backscreen2.width),
-                                     (uint32_t)(backscreen2.height), pal.get());
+//
+// Copies the current frame and queues it for writing. Returns false if the
+// queue is full, in which case nothing is captured.
+//
+static bool M_queueShot(bool quiet)
+{
+    {
+        std::lock_guard lock(shotmutex);
+        if(shotsinflight >= SHOTQUEUESIZE)
+            return false;
+    }
 
-            // haleyjd: close the buffer
-            ob.close();
+    shotjob_t *job = new shotjob_t;
+    job->format    = &shotFormats[screenshot_pcx];
+    job->quiet     = quiet;
+    job->data      = nullptr;
+    job->errmsg[0] = '\0';
 
-            // if not successful, remove the file now
-            if(!success)
-            {
-                int t = errno;
-                remove(lbmname);
-                errno = t;
-            }
+    errno = 0;
 
-            // killough 4/18/98: now you can mark it PU_CACHE
-            // Z_ChangeTag(pal, PU_CACHE); - haleyjd 9/30/12: not needed now.
-        }
+    if(!M_openShotFile(*job))
+    {
+        M_reportShot(false, errno, "", false);
+        delete job;
+        return true;
     }
 
-    // 1/18/98 killough: replace "SCREEN SHOT" acknowledgement with sfx
-    // players[consoleplayer].message = "screen shot"
+    // get screen graphics, straight into a buffer the writer will own
+    VBuffer copy;
+    job->width  = uint32_t(vbscreen.width);
+    job->height = uint32_t(vbscreen.height);
+    job->data   = emalloc(byte *, size_t(vbscreen.width) * vbscreen.height);
+    V_InitVBufferFrom(&copy, vbscreen.width, vbscreen.height, vbscreen.height, video.bitdepth, job->data);
+    V_BlitVBuffer(&copy, 0, 0, &vbscreen, 0, 0, vbscreen.width, vbscreen.height);
+    V_FreeVBuffer(&copy);
 
-    // killough 10/98: print error message and change sound effect if error
-    if(!success)
+    // killough 4/18/98: make palette stay around
+    // (PU_CACHE could cause crash)
+    AutoPalette pal(wGlobalDir);
+    byte       *palette = pal.get();
+
+    // haleyjd 11/16/04: make gamma correction optional
+    for(int i = 0; i < 768; i++)
+        job->palette[i] = screenshot_gamma ? gammatable[usegamma][palette[i]] : palette[i];
+
+    std::lock_guard lock(shotmutex);
+    if(!shotthreadstarted)
     {
-        doom_printf("%s", errno ? strerror(errno) : FC_ERROR "Could not take screenshot");
+        std::thread(M_shotThreadFunc).detach();
+        I_AtExit(M_FlushScreenShots);
+        shotthreadstarted = true;
+    }
+    pendingshots[(pendinghead + pendingcount) % SHOTQUEUESIZE] = job;
+    ++pendingcount;
+    ++shotsinflight;
+    shotcv.notify_one();
+
+    return true;
+}
+
+//
+// M_ScreenShot
+//
+// Modified by Lee Killough so that any number of shots can be taken,
+// the code is faster, and no annoying "screenshot" message appears.
+//
+// killough 10/98: improved error-handling
+//
+// The frame is only copied here; encoding happens on the writer thread.
+//
+void M_ScreenShot()
+{
+    if(!M_queueShot(false))
+    {
+        doom_printf(FC_ERROR "Screenshot queue is full");
         S_StartInterfaceSound(GameModeInfo->playerSounds[sk_oof]);
     }
-    else
-        S_StartInterfaceSound(GameModeInfo->c_BellSound);
 }
 
-// EOF
+//
+// Queues the frame just drawn while a frame dump is running. Frames are
+// skipped rather than waited for if the writer falls behind.
+//
+void M_FrameDump()
+{
+    if(!framedumpleft)
+        return;
+
+    if(!M_queueShot(true))
+    {
+        ++framedumpdropped;
+        return;
+    }
+
+    if(framedumpleft > 0 && !--framedumpleft)
+        C_Printf("Frame dump finished, %d frames dropped\n", framedumpdropped);
+}
+
+//
+// Reports shots finished by the writer thread. Called every tic.
+//
+void M_UpdateScreenShots()
+{
+    shotjob_t *done[SHOTQUEUESIZE];
+    int        numdone;
+    {
+        std::lock_guard lock(shotmutex);
+        if(!finishedcount)
+            return;
+        numdone = finishedcount;
+        memcpy(done, finishedshots, numdone * sizeof(*done));
+        finishedcount  = 0;
+        shotsinflight -= numdone;
+    }
+
+    for(int i = 0; i < numdone; i++)
+    {
+        M_reportShot(done[i]->success, done[i]->error, done[i]->errmsg, done[i]->quiet);
+        delete done[i];
+    }
+}
+
+//
+// Waits for all queued shots to be written. Called at exit.
+//
+static void M_FlushScreenShots()
+{
+    for(;;)
+    {
+        {
+            std::lock_guard lock(shotmutex);
+            if(shotsinflight == finishedcount)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
 
+//=============================================================================
+//
+// Console Commands
+//
+
+CONSOLE_COMMAND(framedump, 0)
+{
+    if(!Console.argc)
+    {
+        C_Printf("dumps every displayed frame as a screenshot.\n"
+                 "usage: framedump <frames> (-1 for no limit, 0 to stop)\n");
+        return;
+    }
+
+    framedumpleft    = Console.argv[0]->toInt();
+    framedumpdropped = 0;
+    if(!framedumpleft)
+        C_Printf("Frame dump stopped\n");
+}
+
+// EOF
@@ -28,6 +28,8 @@ extern int screenshot_pcx;   // killough 10/98
 extern int screenshot_gamma; // haleyjd  03/06
 
 void M_ScreenShot(void);
+void M_FrameDump();
+void M_UpdateScreenShots();
 
 #endif
 
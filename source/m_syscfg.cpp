@@ -236,9 +236,12 @@ static default_t sysdefaults[] = {
     DEFAULT_BOOL("i_forcefeedback", &i_forcefeedback, nullptr, true, default_t::wad_no,
                  "1 to enable force feedback through gamepads where supported"),
 
-    DEFAULT_INT("r_numcontexts", &r_numcontexts, nullptr, 1, 1, UL, default_t::wad_no,
+    DEFAULT_INT("r_numcontexts", &r_renderthreads, nullptr, 1, 1, UL, default_t::wad_no,
                 "Amount of renderer threads to run"),
 
+    DEFAULT_INT("r_contextsplit", &r_contextsplit, nullptr, 1, 1, 4, default_t::wad_no,
+                "Column strips per renderer thread (more balances portal-heavy views better)"),
+
 #ifdef _SDL_VER
     DEFAULT_INT("displaynum", &displaynum, nullptr, 0, 0, UL, default_t::wad_no,
                 "Display number that the window appears on"),
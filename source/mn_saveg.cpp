@@ -238,6 +238,9 @@ static void MN_readSaveStrings()
 
     e_saveSlots.clear();
 
+    // don't read saves still being written
+    P_FinishSaveGames();
+
     // test for failure
     if(std::error_code ec; !fs::is_directory(basesavegame, ec))
         return;
@@ -41,10 +41,12 @@
 #include "z_zone.h"
 
 #include "c_io.h"
+#include "c_runcmd.h"
 #include "d_event.h"
 #include "doomstat.h"
 #include "d_io.h" // SoM 3/14/2002: strncasecmp
 #include "g_game.h"
+#include "m_misc.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
 #include "p_saveg.h"
@@ -53,14 +55,30 @@
 #include "r_defs.h"
 #include "r_state.h"
 
+#include "../zlib/zlib.h"
+
 #define MAXHUBLEVELS 128
 
+//
+// Saved levels are kept in memory, deflated. Once they would take more than
+// hub_memorylimit kilobytes (0 for no limit) further ones go to temp files.
+//
 struct hublevel_t
 {
-    char  levelname[8];
-    char *tmpfile; // temporary file holding the saved level
+    char   levelname[8];
+    char  *tmpfile;  // temporary file holding the saved level
+    byte  *data;     // or the compressed saved level
+    size_t datasize; // compressed size
+    size_t rawsize;  // size of the save it inflates to
 };
 
+int hub_memorylimit;
+
+static size_t hub_memoryused; // compressed bytes held by all hub levels
+
+// holds the level being loaded until the load happens
+static PODCollection<byte> hub_loadbuffer;
+
 extern char gamemapname[9];
 
 // sf: set when we are changing to
@@ -88,13 +106,21 @@ void P_ClearHubs(void)
 {
     int i;
 
+    P_FinishSaveGames();
+
     for(i = 0; i < num_hub_levels; i++)
     {
         if(hub_levels[i].tmpfile)
             remove(hub_levels[i].tmpfile);
+        if(hub_levels[i].data)
+        {
+            efree(hub_levels[i].data);
+            hub_levels[i].data = nullptr;
+        }
     }
 
     num_hub_levels = 0;
+    hub_memoryused = 0;
 
 #if 0
     // clear the hub_script
@@ -139,7 +165,10 @@ static hublevel_t *HublevelForName(char *name)
 static hublevel_t *AddHublevel(char *levelname)
 {
     strncpy(hub_levels[num_hub_levels].levelname, levelname, 8);
-    hub_levels[num_hub_levels].tmpfile = nullptr;
+    hub_levels[num_hub_levels].tmpfile  = nullptr;
+    hub_levels[num_hub_levels].data     = nullptr;
+    hub_levels[num_hub_levels].datasize = 0;
+    hub_levels[num_hub_levels].rawsize  = 0;
 
     return &hub_levels[num_hub_levels++];
 }
@@ -157,7 +186,44 @@ static void SaveHubLevel(void)
     if(!hublevel)
         hublevel = AddHublevel(levelmapname);
 
-    // allocate a temp. filename for save
+    // drop the previous save of this level
+    if(hublevel->data)
+    {
+        hub_memoryused -= hublevel->datasize;
+        efree(hublevel->data);
+        hublevel->data = nullptr;
+    }
+
+    PODCollection<byte> save;
+    P_SaveCurrentLevel(nullptr, hubdesc, &save);
+
+    if(!save.isEmpty())
+    {
+        const size_t limit = size_t(hub_memorylimit) * 1024;
+        uLongf       zsize = compressBound(uLong(save.getLength()));
+        byte        *zdata = emalloc(byte *, zsize);
+
+        if(compress2(zdata, &zsize, &save[0], uLong(save.getLength()), Z_BEST_SPEED) == Z_OK &&
+           (!limit || hub_memoryused + zsize <= limit))
+        {
+            hublevel->data     = erealloc(byte *, zdata, zsize);
+            hublevel->datasize = zsize;
+            hublevel->rawsize  = save.getLength();
+            hub_memoryused    += zsize;
+
+            // an older copy on disk is stale now
+            if(hublevel->tmpfile)
+            {
+                P_FinishSaveGames();
+                remove(hublevel->tmpfile);
+            }
+            return;
+        }
+
+        efree(zdata);
+    }
+
+    // over the limit: spill to disk
     if(!hublevel->tmpfile)
         hublevel->tmpfile = temp_hubfile();
 
@@ -176,6 +242,19 @@ static void LoadHubLevel(char *levelname)
         G_SetGameMapName(levelname);
         gameaction = ga_loadlevel;
     }
+    else if(hublevel->data)
+    {
+        // found saved level in memory: inflate and reload
+        uLongf rawsize = uLong(hublevel->rawsize);
+        hub_loadbuffer.resize(hublevel->rawsize);
+        if(uncompress(&hub_loadbuffer[0], &rawsize, hublevel->data, uLong(hublevel->datasize)) != Z_OK ||
+           rawsize != hublevel->rawsize)
+        {
+            I_Error("LoadHubLevel: saved level %.8s is corrupt\n", levelname);
+        }
+        G_LoadGameFromMemory(hub_loadbuffer);
+        hub_changelevel = true;
+    }
     else
     {
         // found saved level: reload
@@ -295,5 +374,7 @@ void P_RestorePlayerPosition(void)
     P_SetThingPosition(save_player->mo);
 }
 
-// EOF
+VARIABLE_INT(hub_memorylimit, nullptr, 0, UL, nullptr);
+CONSOLE_VARIABLE(hub_memorylimit, hub_memorylimit, 0) {}
 
+// EOF
@@ -36,6 +36,7 @@ void P_RestorePlayerPosition();
 void P_HubReborn();
 
 extern bool hub_changelevel;
+extern int  hub_memorylimit; // KB of compressed hub levels kept in memory, 0 for no limit
 
 #endif
 
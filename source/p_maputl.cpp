@@ -27,6 +27,8 @@
 //
 
 #include <assert.h>
+#include <algorithm>
+#include <functional>
 #include "z_zone.h"
 
 #include "doomstat.h"
@@ -1559,6 +1561,41 @@ void P_CheckSpriteTouchingSectorLists()
     }
 }
 
+//
+// InterceptQueue::build
+//
+// Orders the intercepts with a heap rather than sorting them all, since most
+// traversals stop at one of the first few.
+//
+void InterceptQueue::build(intercept_t *intercepts, size_t count)
+{
+    base = intercepts;
+    heap.clear();
+    for(size_t i = 0; i < count; i++)
+    {
+        if(intercepts[i].frac == D_MAXINT)
+            continue;
+        // sign flipped so unsigned order is signed order; index breaks ties
+        heap.push_back(uint64_t(uint32_t(intercepts[i].frac) ^ 0x80000000u) << 32 | uint32_t(i));
+    }
+    std::make_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+}
+
+//
+// InterceptQueue::pop
+//
+// Returns the nearest intercept left, or nullptr when none are left.
+//
+intercept_t *InterceptQueue::pop()
+{
+    if(heap.empty())
+        return nullptr;
+    std::pop_heap(heap.begin(), heap.end(), std::greater<uint64_t>());
+    const uint64_t key = heap.back();
+    heap.pop_back();
+    return base + uint32_t(key);
+}
+
 //----------------------------------------------------------------------------
 //
 // $Log: p_maputl.c,v $
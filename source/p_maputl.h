@@ -135,6 +135,24 @@ public:
     VisitList polys;
 };
 
+//
+// Hands out a list of intercepts nearest first. On equal fracs the one added
+// first comes first, as with the old repeated search for the smallest frac.
+// Intercepts at D_MAXINT are never handed out. The key storage is kept from
+// one traversal to the next.
+//
+class InterceptQueue
+{
+public:
+    void build(intercept_t *intercepts, size_t count);
+
+    intercept_t *pop();
+
+private:
+    intercept_t          *base = nullptr;
+    std::vector<uint64_t> heap; // min-heap of frac and index keys
+};
+
 using traverser_t = bool (*)(intercept_t *in, void *context);
 
 fixed_t               P_AproxDistance(fixed_t dx, fixed_t dy);
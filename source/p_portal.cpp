@@ -33,6 +33,7 @@
 #include "polyobj.h"
 #include "p_portal.h"
 #include "p_portalblockmap.h"
+#include "p_sector.h"
 #include "p_setup.h"
 #include "p_slopes.h"
 #include "p_user.h"
@@ -1256,6 +1257,9 @@ void P_SetSectorHeight(sector_t &sec, surf_e surf, fixed_t h)
     surface.height     = h;
     surface.heightf    = M_FixedToFloat(surface.height);
 
+    // interpolation: it can move between now and the next tic
+    P_MarkSectorMoved(sec);
+
     // Update slope origin
     if(surface.slope)
     {
@@ -21,6 +21,11 @@
 // Authors: James Haley, David Hill, Ioan Chera, Max Waine
 //
 
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 #include "z_zone.h"
 
 #include "acs_intr.h"
@@ -35,6 +40,7 @@
 #include "e_weapons.h"
 #include "g_dmflag.h"
 #include "g_game.h"
+#include "i_system.h"
 #include "m_buffer.h"
 #include "p_info.h"
 #include "p_spec.h"
@@ -57,6 +63,8 @@
 
 #include <stdexcept>
 
+#include "../zlib/zlib.h"
+
 // Pads save_p to a 4-byte boundary
 //  so that the load/save works on SGI&Gecko.
 // #define PADSAVEP()    do { save_p += (4 - ((int) save_p & 3)) & 3; } while (0)
@@ -1587,6 +1595,262 @@ static void P_ArchiveACS(SaveArchive &arc)
     ACS_Archive(arc);
 }
 
+//============================================================================
+//
+// Background Writer
+//
+// Everything past the header (the part the save menu reads) is archived to
+// memory and handed to a writer thread, which compresses it with zlib and
+// writes the file. Results are reported by P_UpdateSaveGames on the main
+// thread, since the console must not be touched from the writer.
+//
+// From save version 23 the body follows the header as:
+//   uint8  compression (SAVEBODY_*)
+//   uint32 length of the archived body
+//   uint32 length of the stored data that follows
+//
+
+enum savebodytype_e : uint8_t
+{
+    SAVEBODY_STORED, // used for in-memory backups
+    SAVEBODY_ZLIB,
+};
+
+static constexpr size_t SAVEBODY_SIZE_THRESHOLD = 512 * 1024 * 1024;
+static constexpr int    SAVEQUEUESIZE           = 4; // saves that may be waiting at once
+
+struct savejob_t
+{
+    OutBuffer           ob; // file, created on the main thread
+    char                filename[PATH_MAX + 1];
+    PODCollection<byte> header, body; // freed on the main thread
+
+    // results
+    bool success;
+    int  error; // errno from the writer thread
+};
+
+static std::mutex              savemutex;
+static std::condition_variable savecv;
+static bool                    savethreadstarted; // writer is started once and runs until exit
+static savejob_t              *writingsave;       // job the writer is working on, if any
+static savejob_t              *pendingsaves[SAVEQUEUESIZE];
+static int                     pendinghead, pendingcount;
+static savejob_t              *finishedsaves[SAVEQUEUESIZE];
+static int                     finishedcount;
+static int                     savesinflight; // queued, being written, or awaiting report
+
+//
+// Compresses and writes out one save. Runs on the writer thread.
+//
+static bool P_writeSaveJob(savejob_t &job)
+{
+    const uLong rawsize   = uLong(job.body.getLength());
+    uLongf      zsize     = compressBound(rawsize);
+    byte       *zbuffer   = emalloc(byte *, zsize);
+    const byte *body      = rawsize ? &job.body[0] : nullptr;
+    bool        compressed = compress2(zbuffer, &zsize, body, rawsize, Z_BEST_SPEED) == Z_OK;
+
+    bool ok = job.ob.write(&job.header[0], job.header.getLength());
+    ok      = ok && job.ob.writeUint8(compressed ? SAVEBODY_ZLIB : SAVEBODY_STORED);
+    ok      = ok && job.ob.writeUint32(uint32_t(rawsize));
+    if(compressed)
+        ok = ok && job.ob.writeUint32(uint32_t(zsize)) && job.ob.write(zbuffer, zsize);
+    else
+        ok = ok && job.ob.writeUint32(uint32_t(rawsize)) && (!rawsize || job.ob.write(body, rawsize));
+
+    efree(zbuffer);
+    return ok;
+}
+
+//
+// Writer thread loop
+//
+static void P_saveThreadFunc()
+{
+    for(;;)
+    {
+        savejob_t *job;
+        {
+            std::unique_lock lock(savemutex);
+            savecv.wait(lock, [] { return pendingcount > 0; });
+            job         = pendingsaves[pendinghead];
+            writingsave = job;
+            pendinghead = (pendinghead + 1) % SAVEQUEUESIZE;
+            --pendingcount;
+        }
+
+        errno        = 0;
+        job->success = P_writeSaveJob(*job);
+        job->error   = errno;
+        job->ob.close();
+
+        // Remove the partial file
+        if(!job->success)
+            remove(job->filename);
+
+        std::lock_guard lock(savemutex);
+        finishedsaves[finishedcount++] = job;
+        writingsave                    = nullptr;
+    }
+}
+
+//
+// Returns true if a queued save, or the one being written, goes to the given
+// file. Call with savemutex held.
+//
+static bool P_saveFileBusy(const char *filename)
+{
+    if(writingsave && !strcmp(writingsave->filename, filename))
+        return true;
+
+    for(int i = 0; i < pendingcount; i++)
+    {
+        if(!strcmp(pendingsaves[(pendinghead + i) % SAVEQUEUESIZE]->filename, filename))
+            return true;
+    }
+
+    return false;
+}
+
+//
+// Reports saves finished by the writer thread. Called every tic.
+//
+void P_UpdateSaveGames()
+{
+    savejob_t *done[SAVEQUEUESIZE];
+    int        numdone;
+    {
+        std::lock_guard lock(savemutex);
+        if(!finishedcount)
+            return;
+        numdone = finishedcount;
+        memcpy(done, finishedsaves, numdone * sizeof(*done));
+        finishedcount  = 0;
+        savesinflight -= numdone;
+    }
+
+    for(int i = 0; i < numdone; i++)
+    {
+        if(!done[i]->success)
+        {
+            const char *str = done[i]->error ? strerror(done[i]->error) : FC_ERROR "Could not save game: Error unknown";
+            doom_printf("%s", str);
+        }
+        delete done[i];
+    }
+}
+
+//
+// Waits until every queued save is on disk. Needed before anything reads
+// save files back, and at exit.
+//
+void P_FinishSaveGames()
+{
+    for(;;)
+    {
+        {
+            std::lock_guard lock(savemutex);
+            if(savesinflight == finishedcount)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    P_UpdateSaveGames();
+}
+
+//
+// Hands a finished archive to the writer thread. The file is created here so
+// that failing to open it is reported right away. Returns false if it could
+// not be.
+//
+static bool P_queueSave(const char *filename, OutMemoryBuffer &header, OutMemoryBuffer &body)
+{
+    // Make room; saves are never dropped. Also wait out any earlier save to
+    // the same file, since creating it again would truncate it under the writer.
+    for(;;)
+    {
+        {
+            std::lock_guard lock(savemutex);
+            if(savesinflight - finishedcount < SAVEQUEUESIZE && !P_saveFileBusy(filename))
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    P_UpdateSaveGames();
+
+    savejob_t *job = new savejob_t;
+    if(!job->ob.createFile(filename, 512 * 1024, OutBuffer::NENDIAN))
+    {
+        delete job;
+        return false;
+    }
+
+    strncpy(job->filename, filename, PATH_MAX);
+    job->filename[PATH_MAX] = '\0';
+    job->header             = header.takeData();
+    job->body               = body.takeData();
+
+    std::lock_guard lock(savemutex);
+    if(!savethreadstarted)
+    {
+        std::thread(P_saveThreadFunc).detach();
+        I_AtExit(P_FinishSaveGames);
+        savethreadstarted = true;
+    }
+    pendingsaves[(pendinghead + pendingcount) % SAVEQUEUESIZE] = job;
+    ++pendingcount;
+    ++savesinflight;
+    savecv.notify_one();
+
+    return true;
+}
+
+//
+// Reads the save body that follows the header and makes the archive read
+// from it from here on.
+//
+static void P_readSaveBody(SaveArchive &arc, IInBuffer &inBuffer, PODCollection<byte> &body,
+                           InMemoryBuffer &bodyBuffer)
+{
+    uint8_t  type;
+    uint32_t rawsize, storedsize;
+    inBuffer.readUint8(type);
+    inBuffer.readUint32(rawsize);
+    inBuffer.readUint32(storedsize);
+
+    if(rawsize > SAVEBODY_SIZE_THRESHOLD || storedsize > SAVEBODY_SIZE_THRESHOLD)
+        throw std::runtime_error("Bad save game: body too large");
+
+    PODCollection<byte> stored;
+    stored.resize(storedsize);
+    if(storedsize && inBuffer.read(&stored[0], storedsize) != storedsize)
+        throw std::runtime_error("Bad save game: body truncated");
+
+    switch(type)
+    {
+    case SAVEBODY_STORED:
+        if(storedsize != rawsize)
+            throw std::runtime_error("Bad save game: body size mismatch");
+        body = std::move(stored);
+        break;
+    case SAVEBODY_ZLIB:
+    {
+        uLongf destsize = rawsize;
+        body.resize(rawsize);
+        if(!rawsize || uncompress(&body[0], &destsize, &stored[0], storedsize) != Z_OK || destsize != rawsize)
+            throw std::runtime_error("Bad save game: could not decompress");
+        break;
+    }
+    default:
+        throw std::runtime_error("Bad save game: unknown compression");
+    }
+
+    bodyBuffer.setData(&body);
+    arc.setLoadFile(&bodyBuffer);
+}
+
 //============================================================================
 //
 // Saving - Main Routine
@@ -1594,32 +1858,23 @@ static void P_ArchiveACS(SaveArchive &arc)
 
 static constexpr size_t SAVESTRINGSIZE = 24;
 
+//
+// The archive is built in memory. Saves to file are then compressed and
+// written by the writer thread; in-memory backups keep the body stored.
+//
 void P_SaveCurrentLevel(char *filename, char *description, PODCollection<byte> *memoryBackup)
 {
     int             i;
     char            name2[VERSIONSIZE];
     const char     *fn;
-    OutBuffer       savefile;
-    OutMemoryBuffer backupBuffer;
+    OutMemoryBuffer headerBuffer;
+    OutMemoryBuffer bodyBuffer;
 
     bool        saveToFile = !memoryBackup;
-    IOutBuffer *outBuffer  = memoryBackup ? &backupBuffer : static_cast<IOutBuffer *>(&savefile);
+    IOutBuffer *outBuffer  = &headerBuffer;
 
     SaveArchive arc(outBuffer);
 
-    if(saveToFile)
-    {
-        if(!savefile.createFile(filename, 512 * 1024, OutBuffer::NENDIAN))
-        {
-            const char *str = errno ? strerror(errno) : FC_ERROR "Could not save game: Error unknown";
-            doom_printf("%s", str);
-            return;
-        }
-
-        // Enable buffered IO exceptions
-        savefile.setThrowing(true);
-    }
-
     try
     {
         arc.archiveCString(description, SAVESTRINGSIZE);
@@ -1705,6 +1960,9 @@ void P_SaveCurrentLevel(char *filename, char *description, PODCollection<byte> *
 
         arc << dmflags;
 
+        // the rest goes into the body
+        arc.setSaveFile(&bodyBuffer);
+
         // killough 3/22/98: add Z_CheckHeap after each call to ensure consistency
         // haleyjd 07/06/09: just Z_CheckHeap after the end. This stuff works by now.
 
@@ -1732,23 +1990,33 @@ void P_SaveCurrentLevel(char *filename, char *description, PODCollection<byte> *
         // An IO error occurred while trying to save.
         const char *str = errno ? strerror(errno) : FC_ERROR "Could not save game: Error unknown";
         doom_printf("%s", str);
-
-        // Close the file and remove it
-        if(saveToFile)
-        {
-            savefile.setThrowing(false);
-            savefile.close();
-
-            remove(filename);
-        }
         return;
     }
 
-    // Close the save file
     if(saveToFile)
-        savefile.close();
+    {
+        errno = 0;
+        if(!P_queueSave(filename, headerBuffer, bodyBuffer))
+        {
+            const char *str = errno ? strerror(errno) : FC_ERROR "Could not save game: Error unknown";
+            doom_printf("%s", str);
+            return;
+        }
+    }
     else
-        *memoryBackup = backupBuffer.takeData();
+    {
+        const uint32_t bodysize = uint32_t(bodyBuffer.getLength());
+
+        headerBuffer.writeUint8(SAVEBODY_STORED);
+        headerBuffer.writeUint32(bodysize);
+        headerBuffer.writeUint32(bodysize);
+
+        PODCollection<byte> body = bodyBuffer.takeData();
+        if(bodysize)
+            headerBuffer.write(&body[0], bodysize);
+
+        *memoryBackup = headerBuffer.takeData();
+    }
 
     // Check the heap.
     Z_CheckHeap();
@@ -1762,7 +2030,7 @@ void P_SaveCurrentLevel(char *filename, char *description, PODCollection<byte> *
 // Loading -- Main Routine
 //
 
-void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
+void P_LoadGame(const char *filename, const PODCollection<byte> *backup, bool fallback)
 {
     int            i;
     IInBuffer     *inBuffer;
@@ -1781,9 +2049,16 @@ void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
 
     SaveArchive arc(inBuffer);
 
+    // compressed saves are read from here once past the header
+    PODCollection<byte> body;
+    InMemoryBuffer      bodyBuffer;
+
     PODCollection<byte> backupBuffer;
     if(loadFromFile)
     {
+        // it may still be being written
+        P_FinishSaveGames();
+
         if(!loadfile.openFile(filename, InBuffer::NENDIAN))
         {
             doom_warningf("Failed to load savegame %s\n", filename);
@@ -2004,6 +2279,9 @@ void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
         // haleyjd 04/14/03: load dmflags
         arc << ::dmflags;
 
+        if(arc.saveVersion() >= 23)
+            P_readSaveBody(arc, *inBuffer, body, bodyBuffer);
+
         // dearchive all the modifications
         P_ArchivePlayers(arc);
         P_ArchiveWorld(arc);
@@ -2035,7 +2313,7 @@ void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
     {
         if(loadFromFile && !backupBuffer.isEmpty())
         {
-            P_LoadGame(nullptr, &backupBuffer);
+            P_LoadGame(nullptr, &backupBuffer, true);
 
             return;
         }
@@ -2046,7 +2324,7 @@ void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
         if(loadFromFile && !backupBuffer.isEmpty())
         {
             doom_warningf("P_LoadGame: failed loading game: %s\n", e.GetMessage());
-            P_LoadGame(nullptr, &backupBuffer);
+            P_LoadGame(nullptr, &backupBuffer, true);
             return;
         }
         I_Error("P_LoadGame: failed loading game: %s\n", e.GetMessage());
@@ -2086,7 +2364,7 @@ void P_LoadGame(const char *filename, const PODCollection<byte> *backup)
     if(::hub_changelevel)
         P_RestorePlayerPosition();
 
-    if(!loadFromFile && backup)
+    if(fallback)
         doom_warningf("Failed loading damaged save game");
 }
 
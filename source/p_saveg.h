@@ -71,7 +71,7 @@ protected:
     IOutBuffer *savefile; // valid when saving
     IInBuffer  *loadfile; // valid when loading
 
-    static constexpr int WRITE_SAVE_VERSION = 22; // Version of saves that EE writes
+    static constexpr int WRITE_SAVE_VERSION = 23; // Version of saves that EE writes
     int                  read_save_version;       // Version of currently-read save
 
 public:
@@ -89,6 +89,10 @@ public:
     IOutBuffer *getSaveFile() { return savefile; }
     IInBuffer  *getLoadFile() { return loadfile; }
 
+    // Switch buffers partway through, keeping the string table
+    void setSaveFile(IOutBuffer *pSaveFile) { savefile = pSaveFile; }
+    void setLoadFile(IInBuffer *pLoadFile) { loadfile = pLoadFile; }
+
     int saveVersion() const
     {
         if(savefile)
@@ -173,7 +177,10 @@ Thinker     *P_ThinkerForNum(unsigned int n);
 void         P_SetNewTarget(Mobj **mop, Mobj *targ);
 
 void P_SaveCurrentLevel(char *filename, char *description, PODCollection<byte> *memoryBackup);
-void P_LoadGame(const char *filename, const PODCollection<byte> *backup);
+// fallback is set only when restoring the backup taken before a failed load.
+void P_LoadGame(const char *filename, const PODCollection<byte> *backup, bool fallback = false);
+void P_UpdateSaveGames();
+void P_FinishSaveGames();
 
 #endif
 
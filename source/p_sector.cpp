@@ -319,24 +319,36 @@ int EV_SectorFlagsChange(const line_t *line, int tag, int setflags, int clearfla
 // P_SaveSectorPositions
 //
 // Backup current sector floor and ceiling heights to the sector interpolation
-// structures at the beginning of a frame.
+// structures at the beginning of a frame. Sectors that haven't moved since the
+// last time already have them, so only the moved ones are touched.
 //
 void P_SaveSectorPositions()
 {
-    for(int i = 0; i < numsectors; i++)
+    for(int i = 0; i < nummovedsectors; i++)
     {
-        auto &si  = sectorinterps[i];
-        auto &sec = sectors[i];
+        const int index = movedsectors[i];
 
-        si.prevfloorheight    = sec.srf.floor.height;
-        si.prevfloorheightf   = sec.srf.floor.heightf;
-        si.prevceilingheight  = sec.srf.ceiling.height;
-        si.prevceilingheightf = sec.srf.ceiling.heightf;
+        sectorinterps[index].moved = false;
+        P_SaveSectorPosition(sectors[index]);
+    }
+    nummovedsectors = 0;
+}
 
-        if(sec.srf.floor.slope)
-            si.prevfloorslopezf = sec.srf.floor.slope->of.z;
-        if(sec.srf.ceiling.slope)
-            si.prevceilingslopezf = sec.srf.ceiling.slope->of.z;
+//
+// Notes a sector whose floor or ceiling height changed, so that it gets
+// interpolated and its previous position gets saved on the next tic.
+//
+void P_MarkSectorMoved(const sector_t &sec)
+{
+    if(!sectorinterps) // still setting up the level
+        return;
+
+    const int index = int(&sec - sectors);
+    auto     &si    = sectorinterps[index];
+    if(!si.moved)
+    {
+        si.moved                        = true;
+        movedsectors[nummovedsectors++] = index;
     }
 }
 
@@ -140,6 +140,11 @@ sector_t *sectors;
 // haleyjd 01/05/14: sector interpolation data
 sectorinterp_t *sectorinterps;
 
+// Sectors whose heights changed since the last P_SaveSectorPositions, so the
+// only ones that can be interpolated
+int *movedsectors;
+int  nummovedsectors;
+
 // ioanch: list of sector bounding boxes for sector portal seg rejection (coarse)
 // length: numsectors * 4
 sectorbox_t *pSectorBoxes;
@@ -152,8 +157,9 @@ int          numsubsectors;
 subsector_t *subsectors;
 
 int      numnodes;
-node_t  *nodes;
-fnode_t *fnodes;
+node_t     *nodes;
+fnode_t    *fnodes;
+nodebbox_t *nodebboxes;
 
 int     numlines;
 int     numlinesPlusExtra;
@@ -731,7 +737,10 @@ static void P_LoadSectors(int lumpnum)
 //
 static void P_createSectorInterps()
 {
-    sectorinterps = estructalloctag(sectorinterp_t, numsectors, PU_LEVEL);
+    sectorinterps =
+        ecalloctag(sectorinterp_t *, numsectors, sizeof(sectorinterp_t), PU_LEVEL, (void **)&sectorinterps);
+    movedsectors    = emalloctag(int *, numsectors * sizeof(int), PU_LEVEL, (void **)&movedsectors);
+    nummovedsectors = 0;
 
     for(int i = 0; i < numsectors; i++)
     {
@@ -921,13 +930,15 @@ static void P_LoadNodes(int lump)
             level_error = "no nodes in level";
         else
             C_Printf("trivial map (no nodes, one subsector)\n");
-        nodes  = nullptr;
-        fnodes = nullptr;
+        nodes      = nullptr;
+        fnodes     = nullptr;
+        nodebboxes = nullptr;
         return;
     }
 
-    nodes  = estructalloctag(node_t, numnodes, PU_LEVEL);
-    fnodes = estructalloctag(fnode_t, numnodes, PU_LEVEL);
+    nodes      = estructalloctag(node_t, numnodes, PU_LEVEL);
+    fnodes     = estructalloctag(fnode_t, numnodes, PU_LEVEL);
+    nodebboxes = estructalloctag(nodebbox_t, numnodes, PU_LEVEL);
     data   = (byte *)(setupwad->cacheLumpNum(lump, PU_STATIC));
 
     for(i = 0; i < numnodes; i++)
@@ -955,7 +966,7 @@ static void P_LoadNodes(int lump)
             ShortToNodeChild(&(no->children[j]), SwapUShort(mn->children[j]));
 
             for(k = 0; k < 4; ++k)
-                no->bbox[j][k] = SwapShort(mn->bbox[j][k]) << FRACBITS;
+                nodebboxes[i].bbox[j][k] = SwapShort(mn->bbox[j][k]) << FRACBITS;
         }
     }
 
@@ -983,13 +994,15 @@ static void P_LoadNodes_V4(int lump)
             level_error = "no nodes in level";
         else
             C_Printf("trivial map (no nodes, one subsector)\n");
-        nodes  = nullptr;
-        fnodes = nullptr;
+        nodes      = nullptr;
+        fnodes     = nullptr;
+        nodebboxes = nullptr;
         return;
     }
 
-    nodes  = estructalloctag(node_t, numnodes, PU_LEVEL);
-    fnodes = estructalloctag(fnode_t, numnodes, PU_LEVEL);
+    nodes      = estructalloctag(node_t, numnodes, PU_LEVEL);
+    fnodes     = estructalloctag(fnode_t, numnodes, PU_LEVEL);
+    nodebboxes = estructalloctag(nodebbox_t, numnodes, PU_LEVEL);
 
     // skip header
     data += 8;
@@ -1018,12 +1031,83 @@ static void P_LoadNodes_V4(int lump)
             int k;
             no->children[j] = SwapLong(mn->children[j]);
             for(k = 0; k < 4; ++k)
-                no->bbox[j][k] = SwapShort(mn->bbox[j][k]) << FRACBITS;
+                nodebboxes[i].bbox[j][k] = SwapShort(mn->bbox[j][k]) << FRACBITS;
         }
     }
     Z_Free(data - 8);
 }
 
+//
+// P_repackNodes
+//
+// Reorders the loaded nodes depth first, so that a walk down the tree mostly
+// steps to a node next to the one it is on. The root stays at numnodes - 1
+// and every subtree takes the indices right below its root, front child
+// first; nodes the root never reaches go below all of them. The partition
+// array is also aligned to a cache line. Only node numbers change: the
+// subsectors and the shape of the tree stay the same, so every walk visits
+// the same subsectors in the same order.
+//
+static void P_repackNodes()
+{
+    if(numnodes <= 1)
+        return;
+
+    int *newnum = emalloc(int *, numnodes * sizeof(int));
+    for(int i = 0; i < numnodes; i++)
+        newnum[i] = -1;
+
+    int next = numnodes - 1;
+
+    PODCollection<int> stack;
+    stack.add(numnodes - 1);
+    while(!stack.isEmpty())
+    {
+        const int num = stack.pop();
+        if(num < 0 || num >= numnodes || newnum[num] >= 0) // subsector, bad or seen
+            continue;
+        newnum[num] = next--;
+
+        // back child first, so the front one comes out next
+        stack.add(nodes[num].children[1]);
+        stack.add(nodes[num].children[0]);
+    }
+    for(int i = 0; i < numnodes; i++)
+    {
+        if(newnum[i] < 0)
+            newnum[i] = next--;
+    }
+
+    byte   *mem    = emalloctag(byte *, numnodes * sizeof(node_t) + 63, PU_LEVEL, nullptr);
+    node_t *packed = reinterpret_cast<node_t *>((reinterpret_cast<uintptr_t>(mem) + 63) & ~uintptr_t(63));
+
+    fnode_t    *packedfnodes = estructalloctag(fnode_t, numnodes, PU_LEVEL);
+    nodebbox_t *packedbboxes = estructalloctag(nodebbox_t, numnodes, PU_LEVEL);
+
+    for(int i = 0; i < numnodes; i++)
+    {
+        node_t &no = packed[newnum[i]];
+
+        no = nodes[i];
+        for(int &child : no.children)
+        {
+            if(child >= 0 && child < numnodes)
+                child = newnum[child];
+        }
+        packedfnodes[newnum[i]] = fnodes[i];
+        packedbboxes[newnum[i]] = nodebboxes[i];
+    }
+
+    efree(newnum);
+    efree(nodes);
+    efree(fnodes);
+    efree(nodebboxes);
+
+    nodes      = packed;
+    fnodes     = packedfnodes;
+    nodebboxes = packedbboxes;
+}
+
 //
 // P_CheckForDeePBSPv4Nodes
 //
@@ -1523,8 +1607,9 @@ static void P_LoadZNodes(int lump, znodeSignature_t signature)
 
     numnodes = numNodes;
     CheckZNodesOverflow(len, numNodes * 32);
-    nodes  = estructalloctag(node_t, numNodes, PU_LEVEL);
-    fnodes = estructalloctag(fnode_t, numNodes, PU_LEVEL);
+    nodes      = estructalloctag(node_t, numNodes, PU_LEVEL);
+    fnodes     = estructalloctag(fnode_t, numNodes, PU_LEVEL);
+    nodebboxes = estructalloctag(nodebbox_t, numNodes, PU_LEVEL);
 
     for(i = 0; i < numNodes; i++)
     {
@@ -1583,7 +1668,7 @@ static void P_LoadZNodes(int lump, znodeSignature_t signature)
             no->children[j] = (unsigned int)(mn.children[j]);
 
             for(k = 0; k < 4; k++)
-                no->bbox[j][k] = (fixed_t)mn.bbox[j][k] << FRACBITS;
+                nodebboxes[i].bbox[j][k] = (fixed_t)mn.bbox[j][k] << FRACBITS;
         }
     }
 
@@ -3889,6 +3974,11 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask, skill_
         CHECK_ERROR();
     }
 
+    // nodes are final: lay them out for the walks and speed up
+    // R_PointInSubsector from here on
+    P_repackNodes();
+    R_BuildSubsectorGrid();
+
     // ioanch 20160309: reversed P_GroupLines with P_LoadReject to fix the
     // overrun
     P_GroupLines();
@@ -3960,6 +4050,9 @@ void P_SetupLevel(WadDirectory *dir, const char *mapname, int playermask, skill_
     // preload graphics
     R_PrecacheLevel();
 
+    // start decoding the sounds the level's things make
+    S_PrecacheLevelSounds();
+
     R_SetViewSize(screenSize + 3); // sf
 
     // haleyjd 07/28/2010: NOW we are in GS_LEVEL. Not before.
@@ -3999,6 +4092,10 @@ void P_Init()
     R_InitSprites(spritelist);
     P_InitHubs();
     E_InitTerrainTypes(); // haleyjd 07/03/99
+
+    // full BSP descent for every point lookup, for comparing demo runs
+    if(M_CheckParm("-nosubsectorgrid"))
+        r_subsectorgrid = false;
 }
 
 //
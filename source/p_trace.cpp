@@ -858,19 +858,30 @@ void P_UseLines(player_t *player)
 //
 
 // 1/11/98 killough: Intercept limit removed
+// The storage is kept from one trace to the next and only grows.
 static intercept_t *intercepts, *intercept_p;
+static size_t       num_intercepts;
 
-// Check for limit and double size if necessary -- killough
-static void check_intercept()
+// Bumped by every P_PathTraverse, to tell when a traverser function started
+// another trace which reused the intercepts of the one it was called from.
+static unsigned interceptgeneration;
+
+//
+// P_newIntercept
+//
+// Returns the next free slot of the intercepts list, doubling it if needed
+// -- killough
+//
+static intercept_t *P_newIntercept()
 {
-    static size_t num_intercepts;
-    size_t        offset = intercept_p - intercepts;
+    size_t offset = intercept_p - intercepts;
     if(offset >= num_intercepts)
     {
         num_intercepts = num_intercepts ? num_intercepts * 2 : 128;
         intercepts     = erealloc(intercept_t *, intercepts, sizeof(*intercepts) * num_intercepts);
         intercept_p    = intercepts + offset;
     }
+    return intercept_p++;
 }
 
 //
@@ -915,12 +926,11 @@ static bool PIT_AddLineIntercepts(line_t *ld, polyobj_t *po, void *context)
     if(frac < 0)
         return true; // behind source
 
-    check_intercept(); // killough
+    intercept_t *in = P_newIntercept();
 
-    intercept_p->frac    = frac;
-    intercept_p->isaline = true;
-    intercept_p->d.line  = ld;
-    intercept_p++;
+    in->frac    = frac;
+    in->isaline = true;
+    in->d.line  = ld;
 
     return true; // continue
 }
@@ -970,28 +980,26 @@ static bool PIT_AddThingIntercepts(Mobj *thing, void *context)
     if(frac < 0)
         return true; // behind source
 
-    check_intercept(); // killough
+    intercept_t *in = P_newIntercept();
 
-    intercept_p->frac    = frac;
-    intercept_p->isaline = false;
-    intercept_p->d.thing = thing;
-    intercept_p++;
+    in->frac    = frac;
+    in->isaline = false;
+    in->d.thing = thing;
 
     return true; // keep going
 }
 
 //
-// P_TraverseIntercepts
+// P_scanIntercepts
 //
-// Returns true if the traverser function returns true
-// for all lines.
+// The original traversal, searching the whole list for the nearest intercept
+// left before each call. count is the number of searches left and in the
+// last intercept handed out.
 //
 // killough 5/3/98: reformatted, cleaned up
 //
-static bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac, void *context)
+static bool P_scanIntercepts(traverser_t func, fixed_t maxfrac, void *context, int count, intercept_t *in)
 {
-    intercept_t *in    = nullptr;
-    int          count = static_cast<int>(intercept_p - intercepts);
     while(count--)
     {
         fixed_t      dist = D_MAXINT;
@@ -1012,6 +1020,40 @@ static bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac, void *contex
     return true; // everything was traversed
 }
 
+//
+// P_TraverseIntercepts
+//
+// Returns true if the traverser function returns true
+// for all lines.
+//
+// Hands the intercepts out in the order P_scanIntercepts would, from a heap.
+// If a traverser function starts a trace of its own, that trace refills the
+// intercepts list under this one; the rest then goes through
+// P_scanIntercepts so that it sees the refilled list as it always did.
+//
+static bool P_TraverseIntercepts(traverser_t func, fixed_t maxfrac, void *context)
+{
+    static InterceptQueue queue;
+
+    const unsigned generation = interceptgeneration;
+    const int      count      = static_cast<int>(intercept_p - intercepts);
+
+    queue.build(intercepts, count);
+    for(int visited = 1; intercept_t *in = queue.pop(); visited++)
+    {
+        if(in->frac > maxfrac)
+            return true; // checked everything in range
+
+        if(!func(in, context))
+            return false; // don't bother going farther
+        in->frac = D_MAXINT;
+
+        if(interceptgeneration != generation)
+            return P_scanIntercepts(func, maxfrac, context, count - visited, in);
+    }
+    return true; // everything was traversed
+}
+
 //
 // P_PathTraverse
 //
@@ -1035,6 +1077,7 @@ bool P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2, int flags, t
 
     validcount++;
     intercept_p = intercepts;
+    ++interceptgeneration;
 
     if(!((x1 - bmaporgx) & (MAPBLOCKSIZE - 1)))
         x1 += FRACUNIT; // don't side exactly on a line
@@ -3226,7 +3226,8 @@ void R_RenderBSPNode(rendercontext_t &context, int bspnum)
 
         // Possibly divide back space.
 
-        if(!R_checkBBox(context.view, context.bounds, context.bspcontext.solidsegs, bsp->bbox[side ^= 1]))
+        if(!R_checkBBox(context.view, context.bounds, context.bspcontext.solidsegs,
+                        nodebboxes[bspnum].bbox[side ^= 1]))
             return;
 
         bspnum = bsp->children[side];
@@ -130,6 +130,10 @@ struct renderdata_t
 
     const char      *errormessage;
     std::atomic_bool fatalerror;
+
+    // If set, run this instead of rendering the view
+    contexttask_t task;
+    void         *taskdata;
 };
 
 #if (EE_CURRENT_COMPILER == EE_COMPILER_MSVC) && !defined(_DEBUG)
@@ -145,6 +149,13 @@ static void R_runData(renderdata_t *data);
 static renderdata_t *renderdatas      = nullptr;
 static int           prev_numcontexts = 0;
 
+// Threads running contexts, counting the main thread; the first
+// numthreads - 1 renderdatas own the threads
+static int numthreads = 1;
+
+// Next context to be claimed by a thread during a frame
+static std::atomic_int nextcontext;
+
 //
 // Grabs a given render context
 //
@@ -232,6 +243,16 @@ static void R_runData(renderdata_t *data)
 }
 #endif
 
+//
+// Runs contexts until there are none left unclaimed this frame
+//
+static void R_claimContexts()
+{
+    int index;
+    while((index = nextcontext.fetch_add(1, std::memory_order_relaxed)) < r_numcontexts)
+        R_runData(&renderdatas[index]);
+}
+
 //
 // This function is always going on in the background
 // so that threads don't need to constantly be spawned
@@ -249,7 +270,7 @@ static void R_contextThreadFunc(renderdata_t *data)
         {
             data->framewaiting = false;
             data->shouldrun.acquire();
-            R_runData(data);
+            R_claimContexts();
             data->framefinished = true;
         }
 
@@ -284,6 +305,9 @@ void R_InitContexts(const int width)
 {
     r_hascontexts = true;
 
+    numthreads       = emax(r_renderthreads, 1);
+    r_numcontexts    = numthreads > 1 ? numthreads * eclamp(r_contextsplit, 1, 4) : 1;
+    r_numcontexts    = emax(emin(r_numcontexts, width / 16), numthreads); // keep strips usefully wide
     prev_numcontexts = r_numcontexts;
 
     r_globalcontext                     = {};
@@ -332,7 +356,7 @@ void R_InitContexts(const int width)
         // Wait until this context's thread is done running before creating a new one
         while(renderdatas[currentcontext].running.load())
             i_haltimer.Sleep(1);
-        if(currentcontext < r_numcontexts - 1)
+        if(currentcontext < numthreads - 1)
         {
             renderdatas[currentcontext].parallel = true;
             new(&renderdatas[currentcontext].shouldrun) RenderThreadSemaphore(0);
@@ -421,43 +445,34 @@ static void R_checkForContextErrors()
 }
 
 //
-// Runs all the contexts by setting the waiting-for-frame atomics bool to true,
-// then waits for the frame-finished-rendering atomic bools to be true
-// (setting them to false after)
+// Wakes the render threads by setting their waiting-for-frame bools to true,
+// has them and the main thread claim contexts until all are run, then waits
+// for the threads' frame-finished bools to be true (setting them to false
+// after)
 //
-void R_RunContexts()
+static void R_dispatchContexts()
 {
-    int finishedcontexts = 0;
-
     I_SetErrorHandler(R_handleContextError);
 
-    for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+    nextcontext.store(0, std::memory_order_relaxed);
+
+    for(int currentthread = 0; currentthread < numthreads - 1; currentthread++)
     {
-        if(currentcontext < r_numcontexts - 1)
-        {
-            std::lock_guard lock(renderdatas[currentcontext].checkmutex);
-            renderdatas[currentcontext].framewaiting = true;
-            renderdatas[currentcontext].checkframe.notify_one();
-            renderdatas[currentcontext].shouldrun.release();
-        }
-        else
-        {
-            // The last context can be rendered on the main thread
-            R_runData(&renderdatas[currentcontext]);
-            finishedcontexts++;
-        }
+        std::lock_guard lock(renderdatas[currentthread].checkmutex);
+        renderdatas[currentthread].framewaiting = true;
+        renderdatas[currentthread].checkframe.notify_one();
+        renderdatas[currentthread].shouldrun.release();
     }
 
-    while(finishedcontexts != r_numcontexts)
+    // The main thread renders too
+    R_claimContexts();
+
+    for(int currentthread = 0; currentthread < numthreads - 1; currentthread++)
     {
-        for(int currentcontext = 0; currentcontext < r_numcontexts - 1; currentcontext++)
-        {
-            std::unique_lock lock(renderdatas[currentcontext].checkmutex);
-            renderdatas[currentcontext].checkframe.wait(
-                lock, [currentcontext] { return renderdatas[currentcontext].framefinished; });
-            renderdatas[currentcontext].framefinished = false;
-            finishedcontexts++;
-        }
+        std::unique_lock lock(renderdatas[currentthread].checkmutex);
+        renderdatas[currentthread].checkframe.wait(
+            lock, [currentthread] { return renderdatas[currentthread].framefinished; });
+        renderdatas[currentthread].framefinished = false;
     }
 
     I_SetErrorHandler(nullptr);
@@ -465,6 +480,39 @@ void R_RunContexts()
     R_checkForContextErrors();
 }
 
+//
+// Renders the view on all contexts
+//
+void R_RunContexts()
+{
+    for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+        renderdatas[currentcontext].task = nullptr;
+
+    R_dispatchContexts();
+}
+
+//
+// Runs an arbitrary job on the render threads once the frame is drawn, each
+// thread getting its own slice (index out of count). Falls back to running it
+// in one piece on the main thread if there are no render threads.
+//
+void R_RunContextTask(contexttask_t task, void *data)
+{
+    if(!r_hascontexts || !renderdatas || r_numcontexts != prev_numcontexts || r_numcontexts == 1)
+    {
+        task(0, 1, data);
+        return;
+    }
+
+    for(int currentcontext = 0; currentcontext < r_numcontexts; currentcontext++)
+    {
+        renderdatas[currentcontext].task     = task;
+        renderdatas[currentcontext].taskdata = data;
+    }
+
+    R_dispatchContexts();
+}
+
 #if (EE_CURRENT_COMPILER == EE_COMPILER_MSVC) && !defined(_DEBUG)
 #define R_runData R_runDataInner
 #endif
@@ -476,7 +524,10 @@ static void R_runData(renderdata_t *data)
 {
     try
     {
-        R_RenderViewContext(data->context);
+        if(data->task)
+            data->task(data->context.bufferindex, r_numcontexts, data->taskdata);
+        else
+            R_RenderViewContext(data->context);
     }
     catch(qstring &errorMessage)
     {
@@ -484,19 +535,19 @@ static void R_runData(renderdata_t *data)
     }
 }
 
-VARIABLE_INT(r_numcontexts, nullptr, 0, UL, nullptr);
-CONSOLE_VARIABLE(r_numcontexts, r_numcontexts, cf_buffered)
+VARIABLE_INT(r_renderthreads, nullptr, 0, UL, nullptr);
+CONSOLE_VARIABLE(r_numcontexts, r_renderthreads, cf_buffered)
 {
     const int maxcontexts = emax(std::thread::hardware_concurrency(), 1u);
 
-    if(r_numcontexts == 0)
-        r_numcontexts = maxcontexts; // allow scrolling left from 1 to maxcontexts
-    else if(r_numcontexts == maxcontexts + 1)
-        r_numcontexts = 1; // allow scrolling right from maxcontexts to 1
-    else if(r_numcontexts > maxcontexts)
+    if(r_renderthreads == 0)
+        r_renderthreads = maxcontexts; // allow scrolling left from 1 to maxcontexts
+    else if(r_renderthreads == maxcontexts + 1)
+        r_renderthreads = 1; // allow scrolling right from maxcontexts to 1
+    else if(r_renderthreads > maxcontexts)
     {
         C_Printf(FC_ERROR "Warning: r_numcontexts's current maximum is %d, resetting to 1", maxcontexts);
-        r_numcontexts = 1;
+        r_renderthreads = 1;
     }
 
     P_CheckSpriteTouchingSectorLists();
@@ -504,13 +555,20 @@ CONSOLE_VARIABLE(r_numcontexts, r_numcontexts, cf_buffered)
     I_SetMode();
 }
 
+VARIABLE_INT(r_contextsplit, nullptr, 1, 4, nullptr);
+CONSOLE_VARIABLE(r_contextsplit, r_contextsplit, cf_buffered)
+{
+    if(r_renderthreads != 1)
+        I_SetMode();
+}
+
 //
 // True if conditions met to have thorough sprite collection when projecting them.
 //
 bool R_NeedThoroughSpriteCollection()
 {
     return !nodrawers && r_sprprojstyle != R_SPRPROJSTYLE_FAST &&
-           (r_numcontexts != 1 || r_sprprojstyle != R_SPRPROJSTYLE_DEFAULT);
+           (r_renderthreads != 1 || r_sprprojstyle != R_SPRPROJSTYLE_DEFAULT);
 }
 
 // EOF
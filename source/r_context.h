@@ -105,6 +105,13 @@ struct planecontext_t
 
     // spanstart holds the start of a plane span; initialized to 0 at start
     int *spanstart;
+
+    // Swirled flat last built by R_DistortedFlat, and the warp offsets it was
+    // built from. Kept per context since they live on the context's heap.
+    int   swirltex, swirltic, swirlsize;
+    int  *swirloffset;
+    int   swirloffsetsize;
+    byte *distortedflat;
 };
 
 struct portalcontext_t
@@ -190,12 +197,21 @@ inline rendercontext_t r_globalcontext;
 inline int  r_numcontexts;
 inline bool r_hascontexts;
 
+// Render threads asked for, and column strips per thread. Threads claim
+// strips as they finish, so strips behind costly portals get shared out.
+inline int r_renderthreads = 1;
+inline int r_contextsplit  = 1;
+
+// Job run on the render threads outside of view rendering
+using contexttask_t = void (*)(int index, int count, void *data);
+
 rendercontext_t &R_GetContext(int context);
 void             R_FreeContexts();
 void             R_InitContexts(const int width);
 void             R_RefreshContexts();
 void             R_UpdateContextBounds();
 void             R_RunContexts();
+void             R_RunContextTask(contexttask_t task, void *data);
 
 template<typename F>
 void R_ForEachContext(F &&f)
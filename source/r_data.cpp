@@ -42,7 +42,9 @@
 #include "r_patch.h"
 #include "r_sky.h"
 #include "r_state.h"
+#include "r_things.h"
 #include "v_misc.h"
+#include "v_paltable.h"
 #include "v_patchfmt.h"
 #include "v_video.h"
 #include "w_wad.h"
@@ -278,6 +280,30 @@ int tran_filter_pct = 66; // filter percent
 
 #define TSC 12        /* number of fixed point digits in filter percent */
 
+//
+// R_nearestPalColor
+//
+// Picks the color minimizing tot - pal . (r, g, b) for the translucency map
+// builders. Every color's error is computed in one branchless pass, which
+// the compiler vectorizes; on a tie the highest index wins, same as the
+// original downward scan with a strict comparison.
+//
+static byte R_nearestPalColor(const int (&pal)[3][256], const int (&tot)[256], int r, int g, int b)
+{
+    int err[256];
+    int best = INT_MAX;
+    for(int color = 0; color < 256; color++)
+    {
+        err[color] = tot[color] - pal[0][color] * r - pal[1][color] * g - pal[2][color] * b;
+        best       = emin(best, err[color]);
+    }
+
+    int color = 255;
+    while(err[color] != best)
+        --color;
+    return static_cast<byte>(color);
+}
+
 //
 // R_InitTranMap
 //
@@ -366,35 +392,27 @@ void R_InitTranMap(bool force)
             while(--i >= 0);
         }
 
-        // Next, compute all entries using minimum arithmetic.
-        byte *tp = main_tranmap;
-        for(int i = 0; i < 256; ++i)
+        // Next, compute all entries using minimum arithmetic, unless the
+        // cache already has them for this palette and filter.
+        if(!V_PalTableLoad("tranmap", playpal, tran_filter_pct, main_tranmap, 256 * 256))
         {
-            int r1 = pal[0][i] * w2;
-            int g1 = pal[1][i] * w2;
-            int b1 = pal[2][i] * w2;
-
-            if(!(i & 31) && force)
-                V_LoadingIncrease(); // sf
+            V_PalTableParallel(256, [&](int i) {
+                const int r1 = pal[0][i] * w2;
+                const int g1 = pal[1][i] * w2;
+                const int b1 = pal[2][i] * w2;
+
+                byte *tp = main_tranmap + i * 256;
+                for(int j = 0; j < 256; j++)
+                    tp[j] = R_nearestPalColor(pal, tot, pal_w1[0][j] + r1, pal_w1[1][j] + g1, pal_w1[2][j] + b1);
+            });
+            V_PalTableSave("tranmap", playpal, tran_filter_pct, main_tranmap, 256 * 256);
+        }
 
-            for(int j = 0; j < 256; j++, tp++)
-            {
-                int color = 255;
-                int err;
-                int r    = pal_w1[0][j] + r1;
-                int g    = pal_w1[1][j] + g1;
-                int b    = pal_w1[2][j] + b1;
-                int best = INT_MAX;
-                do
-                {
-                    if((err = tot[color] - pal[0][color] * r - pal[1][color] * g - pal[2][color] * b) < best)
-                    {
-                        best = err;
-                        *tp  = color;
-                    }
-                }
-                while(--color >= 0);
-            }
+        // sf: one step per 32 rows
+        if(force)
+        {
+            for(int i = 0; i < 8; i++)
+                V_LoadingIncrease();
         }
     }
 }
@@ -479,32 +497,22 @@ void R_InitSubMap(bool force)
         }
 
         // Next, compute all entries using minimum arithmetic.
-        byte *tp = main_submap;
-        for(int i = 0; i < 256; i++)
+        if(!V_PalTableLoad("submap", playpal, 0, main_submap, 256 * 256))
         {
-            int r1 = pal[0][i];
-            int g1 = pal[1][i];
-            int b1 = pal[2][i];
+            V_PalTableParallel(256, [&](int i) {
+                const int r1 = pal[0][i];
+                const int g1 = pal[1][i];
+                const int b1 = pal[2][i];
 
-            for(int j = 0; j < 256; j++, tp++)
-            {
-                int color = 255;
-                int err;
-                // haleyjd: subtract and clamp to 0
-                int r    = emax(r1 - pal[0][j], 0);
-                int g    = emax(g1 - pal[1][j], 0);
-                int b    = emax(b1 - pal[2][j], 0);
-                int best = INT_MAX;
-                do
+                byte *tp = main_submap + i * 256;
+                for(int j = 0; j < 256; j++)
                 {
-                    if((err = tot[color] - pal[0][color] * r - pal[1][color] * g - pal[2][color] * b) < best)
-                    {
-                        best = err;
-                        *tp  = color;
-                    }
+                    // haleyjd: subtract and clamp to 0
+                    tp[j] = R_nearestPalColor(pal, tot, emax(r1 - pal[0][j], 0), emax(g1 - pal[1][j], 0),
+                                              emax(b1 - pal[2][j], 0));
                 }
-                while(--color >= 0);
-            }
+            });
+            V_PalTableSave("submap", playpal, 0, main_submap, 256 * 256);
         }
     }
 }
@@ -633,21 +641,11 @@ void R_PrecacheLevel(void)
         }
     }
 
+    // the masked drawers only draw baked patches
     for(i = numsprites; --i >= 0;)
     {
         if(hitlist[i])
-        {
-            int j = sprites[i].numframes;
-
-            while(--j >= 0)
-            {
-                int16_t *sflump = sprites[i].spriteframes[j].lump;
-                int      k      = 7;
-                do
-                    wGlobalDir.cacheLumpNum(firstspritelump + sflump[k], PU_CACHE);
-                while(--k >= 0);
-            }
-        }
+            R_BakeSprite(i);
     }
     efree(hitlist);
 }
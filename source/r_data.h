@@ -30,6 +30,7 @@
 #include "m_dllist.h"
 
 class ZoneHeap;
+struct planecontext_t;
 
 enum
 {
@@ -122,7 +123,7 @@ struct texture_t
 // SoM: This is replaced with two functions. For solid walls/skies, we only
 // need the raw column data (direct buffer ptr). For masked mid-textures, we
 // need to return columns from the column list
-const byte     *R_GetRawColumn(ZoneHeap &heap, int tex, int32_t col);
+const byte     *R_GetRawColumn(ZoneHeap &heap, planecontext_t &context, int tex, int32_t col);
 const texcol_t *R_GetMaskedColumn(int tex, int32_t col);
 
 // SoM: This function returns the linear texture buffer (recache if needed)
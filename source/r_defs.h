@@ -226,6 +226,7 @@ struct sectoraction_t
 struct sectorinterp_t
 {
     bool interpolated; // if true, interpolated
+    bool moved;        // if true, in movedsectors
 
     fixed_t prevfloorheight; // previous values, stored for interpolation
     fixed_t prevceilingheight;
@@ -605,13 +606,24 @@ struct seg_t
 //
 // BSP node.
 //
+// Only what the walks test at every node is kept here; the bounding boxes,
+// which only the renderer needs, are in nodebbox_t. Nodes are stored in
+// depth-first order once loaded (see P_repackNodes).
+//
 struct node_t
 {
     fixed_t x, y, dx, dy; // Partition line.
-    fixed_t bbox[2][4];   // Bounding box for each child.
     int     children[2];  // If NF_SUBSECTOR, it's a subsector.
 };
 
+//
+// Bounding boxes of a BSP node's children, at the same index as the node
+//
+struct nodebbox_t
+{
+    fixed_t bbox[2][4]; // Bounding box for each child.
+};
+
 //
 // fnode
 //
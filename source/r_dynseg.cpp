@@ -506,8 +506,9 @@ static void R_SplitLine(dynaseg_t *dseg, dynaseg_t *backdseg, int bspnum)
 {
     while(!(bspnum & NF_SUBSECTOR))
     {
-        node_t        *bsp   = &nodes[bspnum];
+        const node_t  *bsp   = &nodes[bspnum];
         const fnode_t *fnode = &fnodes[bspnum];
+        nodebbox_t    &boxes = nodebboxes[bspnum];
         seg_t         *lseg  = &dseg->seg;
 
         // test vertices against node line
@@ -515,8 +516,8 @@ static void R_SplitLine(dynaseg_t *dseg, dynaseg_t *backdseg, int bspnum)
         int side_v2 = R_PointOnSidePrecise(lseg->v2->x, lseg->v2->y, bsp);
 
         // ioanch 20160226: fix the polyobject visual clipping bug
-        M_AddToBox(bsp->bbox[side_v1], lseg->v1->x, lseg->v1->y);
-        M_AddToBox(bsp->bbox[side_v2], lseg->v2->x, lseg->v2->y);
+        M_AddToBox(boxes.bbox[side_v1], lseg->v1->x, lseg->v1->y);
+        M_AddToBox(boxes.bbox[side_v2], lseg->v2->x, lseg->v2->y);
 
         // get distance of vertices from partition line
         double dist_v1 = R_PartitionDistance(lseg->v1->fx, lseg->v1->fy, fnode);
@@ -552,8 +553,8 @@ static void R_SplitLine(dynaseg_t *dseg, dynaseg_t *backdseg, int bspnum)
             if(R_IntersectPoint(lseg, bsp, *nv))
             {
                 // ioanch 20160722: fix the polyobject visual clipping bug (more needed)
-                M_AddToBox(bsp->bbox[0], nv->x, nv->y);
-                M_AddToBox(bsp->bbox[1], nv->x, nv->y);
+                M_AddToBox(boxes.bbox[0], nv->x, nv->y);
+                M_AddToBox(boxes.bbox[1], nv->x, nv->y);
 
                 // create new dynaseg from nv to seg->v2
                 nds = R_CreateDynaSeg(dseg, nv, lseg->dyv2);
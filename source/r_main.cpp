@@ -41,6 +41,7 @@
 #include "hu_over.h"
 #include "i_video.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "m_random.h"
 #include "mn_engin.h"
 #include "p_chase.h"
@@ -717,6 +718,155 @@ void R_Init()
     R_InitParticles(); // haleyjd
 }
 
+//
+// Point-in-subsector grid
+//
+// A grid over the level, built at load, whose cells hold the node at which
+// the BSP descent of the points inside them stops being the same for all of
+// them, or the subsector if it never does. Lookups in the grid start their
+// descent from there.
+//
+bool r_subsectorgrid = true;
+
+static constexpr int SSGRIDSHIFT = FRACBITS + 6; // 64 unit cells
+
+static int    *ssgrid; // PU_LEVEL, cleared when the level is freed
+static int     ssgridwidth, ssgridheight;
+static fixed_t ssgridx, ssgridy;
+
+//
+// R_cellSide
+//
+// Returns the side R_PointOnSide gives for every point of the box from
+// x0,y0 to x1,y1 inclusive, or -1 if not all of them get the same one.
+//
+static int R_cellSide(const node_t &node, int64_t x0, int64_t y0, int64_t x1, int64_t y1)
+{
+    if(!node.dx)
+    {
+        if(x1 <= node.x)
+            return node.dy > 0;
+        if(x0 > node.x)
+            return node.dy < 0;
+        return -1;
+    }
+
+    if(!node.dy)
+    {
+        if(y1 <= node.y)
+            return node.dx < 0;
+        if(y0 > node.y)
+            return node.dx > 0;
+        return -1;
+    }
+
+    // Both variants compare the two sides of a cross product. The classic
+    // one truncates the node deltas to whole units and each product down to
+    // fixed point, so only a cross product of at least a whole unit either
+    // way is sure to come out on that side. The sign bit shortcut never
+    // disagrees with a cross product that is clear of zero.
+    int64_t ndx, ndy, margin;
+    if(R_PointOnSide == R_PointOnSidePrecise)
+    {
+        ndx    = node.dx;
+        ndy    = node.dy;
+        margin = 1;
+    }
+    else
+    {
+        ndx    = node.dx >> FRACBITS;
+        ndy    = node.dy >> FRACBITS;
+        margin = FRACUNIT;
+    }
+
+    const int64_t xs[2] = { x0, x1 };
+    const int64_t ys[2] = { y0, y1 };
+
+    int64_t lo = INT64_MAX, hi = INT64_MIN;
+    for(int64_t cx : xs)
+    {
+        for(int64_t cy : ys)
+        {
+            const int64_t cross = (cy - node.y) * ndx - ndy * (cx - node.x);
+
+            lo = emin(lo, cross);
+            hi = emax(hi, cross);
+        }
+    }
+
+    if(lo >= margin)
+        return 1;
+    if(hi <= -margin)
+        return 0;
+    return -1;
+}
+
+//
+// R_BuildSubsectorGrid
+//
+// Builds the point-in-subsector grid for the loaded BSP. Must be called once
+// the nodes and R_PointOnSide are set up, before anything looks up points.
+//
+void R_BuildSubsectorGrid()
+{
+    ssgrid = nullptr;
+    if(!r_subsectorgrid || numnodes <= 0 || !numvertexes)
+        return;
+
+    // the area of the vertices and partition line origins
+    fixed_t minx = D_MAXINT, miny = D_MAXINT, maxx = D_MININT, maxy = D_MININT;
+    for(int i = 0; i < numvertexes; i++)
+    {
+        minx = emin(minx, vertexes[i].x);
+        miny = emin(miny, vertexes[i].y);
+        maxx = emax(maxx, vertexes[i].x);
+        maxy = emax(maxy, vertexes[i].y);
+    }
+    for(int i = 0; i < numnodes; i++)
+    {
+        minx = emin(minx, nodes[i].x);
+        miny = emin(miny, nodes[i].y);
+        maxx = emax(maxx, nodes[i].x);
+        maxy = emax(maxy, nodes[i].y);
+    }
+
+    // R_PointOnSide subtracts the node origin from the point in 32 bits, so
+    // only build where that can't overflow anywhere in the grid
+    static constexpr int64_t CELLSIZE = int64_t(1) << SSGRIDSHIFT;
+    if(int64_t(maxx) - minx + CELLSIZE > D_MAXINT || int64_t(maxy) - miny + CELLSIZE > D_MAXINT)
+        return;
+
+    ssgridx      = minx;
+    ssgridy      = miny;
+    ssgridwidth  = int((int64_t(maxx) - minx) >> SSGRIDSHIFT) + 1;
+    ssgridheight = int((int64_t(maxy) - miny) >> SSGRIDSHIFT) + 1;
+
+    int *grid = ecalloctag(int *, ssgridwidth * ssgridheight, sizeof(*grid), PU_LEVEL, (void **)&ssgrid);
+
+    for(int cy = 0; cy < ssgridheight; cy++)
+    {
+        const int64_t y0 = ssgridy + cy * CELLSIZE;
+        const int64_t y1 = y0 + CELLSIZE - 1;
+        for(int cx = 0; cx < ssgridwidth; cx++)
+        {
+            const int64_t x0 = ssgridx + cx * CELLSIZE;
+            const int64_t x1 = x0 + CELLSIZE - 1;
+
+            int nodenum = numnodes - 1;
+            while(!(nodenum & NF_SUBSECTOR))
+            {
+                const int side = R_cellSide(nodes[nodenum], x0, y0, x1, y1);
+                if(side < 0)
+                    break;
+                nodenum = nodes[nodenum].children[side];
+            }
+            grid[cy * ssgridwidth + cx] = nodenum;
+        }
+    }
+
+    ssgrid = grid;
+}
+
 //
 // R_PointInSubsector
 //
@@ -726,6 +876,13 @@ void R_Init()
 subsector_t *R_PointInSubsector(fixed_t x, fixed_t y)
 {
     int nodenum = numnodes - 1;
+    if(ssgrid)
+    {
+        const unsigned cx = (unsigned(x) - unsigned(ssgridx)) >> SSGRIDSHIFT;
+        const unsigned cy = (unsigned(y) - unsigned(ssgridy)) >> SSGRIDSHIFT;
+        if(x >= ssgridx && y >= ssgridy && cx < unsigned(ssgridwidth) && cy < unsigned(ssgridheight))
+            nodenum = ssgrid[cy * ssgridwidth + cx];
+    }
     while(!(nodenum & NF_SUBSECTOR))
         nodenum = nodes[nodenum].children[R_PointOnSide(x, y, nodes + nodenum)];
     return &subsectors[(nodenum == -1 ? 0 : nodenum & ~NF_SUBSECTOR)];
@@ -882,13 +1039,15 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
 {
     int i;
 
+    // only sectors that moved during the last tic can differ from their
+    // previous positions
     switch(state)
     {
     case SEC_INTERPOLATE:
-        for(i = 0; i < numsectors; i++)
+        for(i = 0; i < nummovedsectors; i++)
         {
-            auto &si  = sectorinterps[i];
-            auto &sec = sectors[i];
+            auto &si  = sectorinterps[movedsectors[i]];
+            auto &sec = sectors[movedsectors[i]];
 
             if(si.prevfloorheight != sec.srf.floor.height || si.prevceilingheight != sec.srf.ceiling.height)
             {
@@ -925,10 +1084,10 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
         }
         break;
     case SEC_NORMAL:
-        for(i = 0; i < numsectors; i++)
+        for(i = 0; i < nummovedsectors; i++)
         {
-            auto &si  = sectorinterps[i];
-            auto &sec = sectors[i];
+            auto &si  = sectorinterps[movedsectors[i]];
+            auto &sec = sectors[movedsectors[i]];
 
             // restore backed up heights
             if(si.interpolated)
@@ -942,6 +1101,8 @@ static void R_setSectorInterpolationState(secinterpstate_e state)
                     slope->of.z = si.backfloorslopezf;
                 if(pslope_t *slope = sec.srf.ceiling.slope; slope)
                     slope->of.z = si.backceilingslopezf;
+
+                si.interpolated = false;
             }
         }
         break;
@@ -1350,8 +1511,7 @@ void R_RenderViewContext(rendercontext_t &context)
     // SoM 12/9/03: render the portals.
     R_RenderPortals(context);
 
-    R_DrawPlanes(context.cmapcontext, *context.heap, context.planecontext.mainhash, context.planecontext.spanstart,
-                 context.view.angle, nullptr);
+    R_DrawPlanes(context.cmapcontext, *context.heap, context.planecontext, context.view.angle, nullptr);
 
     // Check for new console commands.
     // NetUpdate();
@@ -1392,6 +1552,9 @@ void R_RenderPlayerView(player_t *player, camera_t *camerapoint)
     else
         player->mo->intflags &= ~MIF_HIDDENBYQUAKE; // zero it otherwise
 
+    // Sprite patches are only ever baked here on the main thread
+    R_BakeThingSprites();
+
     // We don't need to multithread if we only have one context
     if(r_numcontexts == 1)
         R_RenderViewContext(r_globalcontext);
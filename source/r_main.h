@@ -98,12 +98,15 @@ int        R_PointOnSideClassic(fixed_t x, fixed_t y, const node_t *node);
 int        R_PointOnSidePrecise(fixed_t x, fixed_t y, const node_t *node);
 extern int (*R_PointOnSide)(fixed_t, fixed_t, const node_t *);
 
+extern bool r_subsectorgrid;
+
 int R_PointOnSegSide(fixed_t x, fixed_t y, const seg_t *line);
 
 int          SlopeDiv(unsigned int num, unsigned int den);
 angle_t      R_PointToAngle(const fixed_t viewx, const fixed_t viewy, const fixed_t x, const fixed_t y);
 angle_t      R_PointToAngle2(fixed_t pviewx, fixed_t pviewy, fixed_t x, fixed_t y);
 subsector_t *R_PointInSubsector(fixed_t x, fixed_t y);
+void         R_BuildSubsectorGrid();
 fixed_t      R_GetLerp(bool ignorepause);
 void         R_SectorColormap(cmapcontext_t &context, const viewpoint_t &viewpoint, const rendersector_t *s);
 
@@ -60,6 +60,37 @@ struct patch_t
 #pragma pack(pop)
 #endif
 
+//
+// Baked masked patches
+//
+// A patch converted for the sprite drawers: each column's posts are resolved
+// to absolute rows, touching posts are joined into a single run, and the
+// pixels are copied out next to the run list. Built on the main thread by
+// PatchLoader::CacheMaskedNum before any render context draws the patch, and
+// kept in the lump's fmt_maskedpatch cache until the level ends.
+//
+struct maskedrun_t
+{
+    int32_t     top;    // first row covered by the run
+    int32_t     length; // number of rows
+    const byte *source; // pixels, with one byte of padding on either side
+};
+
+struct maskedpatchcol_t
+{
+    const maskedrun_t *runs;
+    int32_t            numruns; // 0 for an empty column
+};
+
+struct maskedpatch_t
+{
+    int16_t width, height;
+    int16_t leftoffset, topoffset;
+    int16_t firstcolumn, lastcolumn; // non-empty column range; first > last if none
+
+    const maskedpatchcol_t *columns; // [width]
+};
+
 #endif
 
 // EOF
@@ -832,7 +832,8 @@ inline static int32_t R_getSkyColumn(angle_t an, int x, angle_t flip, int offset
 }
 
 // haleyjd: moved here from r_newsky.c
-static void do_draw_newsky(cmapcontext_t &context, ZoneHeap &heap, const angle_t viewangle, visplane_t *pl)
+static void do_draw_newsky(cmapcontext_t &context, ZoneHeap &heap, planecontext_t &planecontext,
+                           const angle_t viewangle, visplane_t *pl)
 {
     cb_column_t column{};
 
@@ -874,7 +875,7 @@ static void do_draw_newsky(cmapcontext_t &context, ZoneHeap &heap, const angle_t
     {
         if((column.y1 = pl->top[x]) <= (column.y2 = pl->bottom[x]))
         {
-            column.source = R_GetRawColumn(heap, skyTexture2, R_getSkyColumn(an, x, 0, offset2));
+            column.source = R_GetRawColumn(heap, planecontext, skyTexture2, R_getSkyColumn(an, x, 0, offset2));
 
             colfunc(column);
         }
@@ -894,7 +895,7 @@ static void do_draw_newsky(cmapcontext_t &context, ZoneHeap &heap, const angle_t
     {
         if((column.y1 = pl->top[x]) <= (column.y2 = pl->bottom[x]))
         {
-            column.source = R_GetRawColumn(heap, skyTexture, R_getSkyColumn(an, x, 0, offset));
+            column.source = R_GetRawColumn(heap, planecontext, skyTexture, R_getSkyColumn(an, x, 0, offset));
 
             colfunc(column);
         }
@@ -910,7 +911,8 @@ static const int MultiplyDeBruijnBitPosition2[32] = {
 //
 // Drawing sky as a background texture instead of a visplane.
 //
-static void R_drawSky(ZoneHeap &heap, angle_t viewangle, const visplane_t *pl, const skyflat_t *skyflat)
+static void R_drawSky(ZoneHeap &heap, planecontext_t &planecontext, angle_t viewangle, const visplane_t *pl,
+                      const skyflat_t *skyflat)
 {
     int                 texture;
     int                 offset = 0;
@@ -1023,7 +1025,7 @@ static void R_drawSky(ZoneHeap &heap, angle_t viewangle, const visplane_t *pl, c
 
         if(column.y1 <= column.y2)
         {
-            column.source = R_GetRawColumn(heap, texture, R_getSkyColumn(an, x, flip, offset));
+            column.source = R_GetRawColumn(heap, planecontext, texture, R_getSkyColumn(an, x, flip, offset));
             colfunc(column);
         }
     }
@@ -1033,8 +1035,8 @@ static void R_drawSky(ZoneHeap &heap, angle_t viewangle, const visplane_t *pl, c
 // New function, by Lee Killough
 // haleyjd 08/30/02: slight restructuring to use hashed sky texture info cache.
 //
-static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, int *const spanstart, const angle_t viewangle,
-                          visplane_t *pl)
+static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, planecontext_t &planecontext,
+                          const angle_t viewangle, visplane_t *pl)
 {
     if(!(pl->minx <= pl->maxx))
         return;
@@ -1043,14 +1045,14 @@ static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, int *const spa
     if(R_IsSkyFlat(pl->picnum) && LevelInfo.doubleSky)
     {
         // NOTE: MBF sky transfers change pl->picnum so it won't go here if set to transfer.
-        do_draw_newsky(context, heap, viewangle, pl);
+        do_draw_newsky(context, heap, planecontext, viewangle, pl);
         return;
     }
 
     skyflat_t *skyflat = R_SkyFlatForPicnum(pl->picnum);
 
     if(skyflat || pl->picnum & PL_SKYFLAT) // sky flat
-        R_drawSky(heap, viewangle, pl, skyflat);
+        R_drawSky(heap, planecontext, viewangle, pl, skyflat);
     else // regular flat
     {
         const texture_t *tex;
@@ -1071,7 +1073,7 @@ static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, int *const spa
         // Hexen animations can control only their own sequence swirling.
         if((r_swirl && textures[picnum]->flags & TF_ANIMATED) || textures[pl->picnum]->flags & TF_SWIRLY)
         {
-            plane.source = R_DistortedFlat(heap, picnum);
+            plane.source = R_DistortedFlat(heap, planecontext, picnum);
             tex = plane.tex = textures[picnum];
         }
         else
@@ -1199,8 +1201,8 @@ static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, int *const spa
 
         for(int x = pl->minx; x <= stop; x++)
         {
-            R_makeSpans(flatfunc, slopefunc, span, slopespan, plane, spanstart, x, pl->top[x - 1], pl->bottom[x - 1],
-                        pl->top[x], pl->bottom[x]);
+            R_makeSpans(flatfunc, slopefunc, span, slopespan, plane, planecontext.spanstart, x, pl->top[x - 1],
+                        pl->bottom[x - 1], pl->top[x], pl->bottom[x]);
         }
     }
 }
@@ -1209,19 +1211,19 @@ static void do_draw_plane(cmapcontext_t &context, ZoneHeap &heap, int *const spa
 // Called after the BSP has been traversed and walls have rendered. This
 // function is also now used to render portal overlays.
 //
-void R_DrawPlanes(cmapcontext_t &context, ZoneHeap &heap, planehash_t &mainhash, int *const spanstart,
-                  const angle_t viewangle, planehash_t *table)
+void R_DrawPlanes(cmapcontext_t &context, ZoneHeap &heap, planecontext_t &planecontext, const angle_t viewangle,
+                  planehash_t *table)
 {
     visplane_t *pl;
     int         i;
 
     if(!table)
-        table = &mainhash;
+        table = &planecontext.mainhash;
 
     for(i = 0; i < table->chaincount; ++i)
     {
         for(pl = table->chains[i]; pl; pl = pl->next)
-            do_draw_plane(context, heap, spanstart, viewangle, pl);
+            do_draw_plane(context, heap, planecontext, viewangle, pl);
     }
 }
 
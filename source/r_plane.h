@@ -48,8 +48,8 @@ extern float *overlayfclip, *overlaycclip;
 
 void R_ClearPlanes(planecontext_t &context, const contextbounds_t &bounds);
 void R_ClearOverlayClips(const contextbounds_t &bounds);
-void R_DrawPlanes(cmapcontext_t &context, ZoneHeap &heap, planehash_t &mainhash, int *const spanstart,
-                  const angle_t viewangle, planehash_t *table);
+void R_DrawPlanes(cmapcontext_t &context, ZoneHeap &heap, planecontext_t &planecontext, const angle_t viewangle,
+                  planehash_t *table);
 
 // Planehash stuff
 planehash_t *R_NewPlaneHash(ZoneHeap &heap, int chaincount);
@@ -29,6 +29,7 @@
 #include "doomstat.h"
 #include "tables.h"
 
+#include "r_context.h"
 #include "r_defs.h"
 #include "r_data.h"
 #include "r_draw.h"
@@ -45,8 +46,7 @@
 // 1 cycle per 32 units (2 in 64)
 #define SWIRLFACTOR2 (8192/32)
 
-static thread_local byte *normalflat;
-int                       r_swirl; // hack
+int r_swirl; // hack
 
 #if 0
 // DEBUG: draw lines on the flat to see the distortion
@@ -69,28 +69,25 @@ static void R_DrawLines(void)
 #define AMP2 2
 #define SPEED 40
 
-static thread_local int   lasttex  = -1;
-static thread_local int   swirltic = -1;
-static thread_local int  *offset;
-static thread_local int   offsetSize;
-static thread_local byte *distortedflat;
-static thread_local int   lastsize;
-
 VALLOCATION(distortedflat)
 {
-    lasttex       = -1;
-    swirltic      = -1;
-    offset        = nullptr;
-    offsetSize    = 0;
-    distortedflat = nullptr;
-    lastsize      = 0;
+    R_ForEachContext([](rendercontext_t &basecontext) {
+        planecontext_t &context = basecontext.planecontext;
+
+        context.swirltex        = -1;
+        context.swirltic        = -1;
+        context.swirlsize       = 0;
+        context.swirloffset     = nullptr;
+        context.swirloffsetsize = 0;
+        context.distortedflat   = nullptr;
+    });
 }
 
 //
 // Generates a distorted flat from a normal one using a two-dimensional
-// sine wave pattern.
+// sine wave pattern. The buffers belong to the given context and its heap.
 //
-byte *R_DistortedFlat(ZoneHeap &heap, int texnum, bool usegametic)
+byte *R_DistortedFlat(ZoneHeap &heap, planecontext_t &context, int texnum, bool usegametic)
 {
     int              i;
     int              reftime  = usegametic ? gametic : leveltime;
@@ -104,6 +101,10 @@ byte *R_DistortedFlat(ZoneHeap &heap, int texnum, bool usegametic)
     int16_t w       = tex->height;
     int     cursize = w * h;
 
+    int  *&offset        = context.swirloffset;
+    int   &offsetSize    = context.swirloffsetsize;
+    byte *&distortedflat = context.distortedflat;
+
     if(cursize * 2 > offsetSize)
     {
         offsetSize    = cursize * 4;
@@ -111,13 +112,13 @@ byte *R_DistortedFlat(ZoneHeap &heap, int texnum, bool usegametic)
         distortedflat = zhrealloc(heap, byte *, distortedflat, offsetSize * sizeof(*distortedflat));
     }
     // Already swirled this one?
-    if(reftime == swirltic && lasttex == texnum)
+    if(reftime == context.swirltic && context.swirltex == texnum)
         return distortedflat;
 
-    lasttex = texnum;
+    context.swirltex = texnum;
 
     // built this tic?
-    if(reftime != swirltic || cursize != lastsize)
+    if(reftime != context.swirltic || cursize != context.swirlsize)
     {
         int x, y;
 
@@ -148,11 +149,11 @@ byte *R_DistortedFlat(ZoneHeap &heap, int texnum, bool usegametic)
             }
         }
 
-        swirltic = reftime;
-        lastsize = cursize;
+        context.swirltic  = reftime;
+        context.swirlsize = cursize;
     }
 
-    normalflat = tex->bufferdata;
+    const byte *normalflat = tex->bufferdata;
 
     byte *distortedmask = distortedflat + cursize;
     for(i = 0; i < cursize; ++i)
@@ -27,13 +27,14 @@
 #include "doomtype.h"
 
 class ZoneHeap;
+struct planecontext_t;
 
 enum
 {
     SWIRL_TICS = 65536 // the amount to set in definition lumps
 };
 
-byte *R_DistortedFlat(ZoneHeap &heap, int flatnum, bool usegametic = false);
+byte *R_DistortedFlat(ZoneHeap &heap, planecontext_t &context, int flatnum, bool usegametic = false);
 
 extern int r_swirl;
 
@@ -226,25 +226,17 @@ void R_RenderMaskedSegRange(cmapcontext_t &cmapcontext, const viewpoint_t &viewp
     }
 }
 
-static const lighttable_t *R_calculateLighting(cmapcontext_t &cmapcontext, const lighttable_t *const *walllights,
-                                               const float dist)
+//
+// Returns the index into a seg's light table for the given distance.
+//
+inline static int R_wallLightIndex(const float dist)
 {
-    // calculate lighting
-    // SoM: ANYRES
-    if(!cmapcontext.fixedcolormap)
-    {
-        // SoM: it took me about 5 solid minutes of looking at the old doom code
-        // and running test levels through it to do the math and get 2560 as the
-        // light distance factor.
-        int index = int(dist * 2560.0f);
-
-        if(index >= MAXLIGHTSCALE)
-            index = MAXLIGHTSCALE - 1;
+    // SoM: it took me about 5 solid minutes of looking at the old doom code
+    // and running test levels through it to do the math and get 2560 as the
+    // light distance factor.
+    const int index = int(dist * 2560.0f);
 
-        return walllights[index];
-    }
-
-    return cmapcontext.fixedcolormap;
+    return index >= MAXLIGHTSCALE ? MAXLIGHTSCALE - 1 : index;
 }
 
 //
@@ -287,10 +279,18 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
         skyplane = R_CheckPlane(planecontext, heap, skyplane, segclip.x1, segclip.x2);
     }
 
+    // Resolve the light tables for each tier once per seg, so that the column
+    // loop only has to index them. A fixed colormap gets a table of its own.
     // haleyjd 06/30/07: cardboard invuln fix.
-    // haleyjd 10/21/08: moved up loop-invariant calculation
+    const lighttable_t        *fixedlights[MAXLIGHTSCALE];
+    const lighttable_t *const *toplights    = segclip.walllights_top;
+    const lighttable_t *const *midlights    = segclip.walllights_mid;
+    const lighttable_t *const *bottomlights = segclip.walllights_bottom;
     if(cmapcontext.fixedcolormap)
-        column.colormap = cmapcontext.fixedcolormap;
+    {
+        std::fill(std::begin(fixedlights), std::end(fixedlights), cmapcontext.fixedcolormap);
+        toplights = midlights = bottomlights = fixedlights;
+    }
 
     for(i = segclip.x1; i <= segclip.x2; i++)
     {
@@ -380,6 +380,8 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
         {
             basescale = 1.0f / (segclip.dist * view.yfoc);
 
+            const int lightindex = R_wallLightIndex(segclip.dist);
+
             column.step = M_FloatToFixed(basescale); // SCALE_TODO: Y scale-factor here
             column.x    = i;
 
@@ -411,10 +413,10 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                             column.y2 = (int)(segclip.high > floorclip[i] ? floorclip[i] : segclip.high);
                             if(column.y2 >= column.y1)
                             {
-                                column.colormap =
-                                    R_calculateLighting(cmapcontext, segclip.walllights_top, segclip.dist);
-                                column.texmid = segclip.toptexmid;
-                                column.source = R_GetRawColumn(heap, segclip.toptex, int(texx + segclip.toffset_top_x));
+                                column.colormap  = toplights[lightindex];
+                                column.texmid    = segclip.toptexmid;
+                                column.source    = R_GetRawColumn(heap, planecontext, segclip.toptex,
+                                                                  int(texx + segclip.toffset_top_x));
                                 column.texheight = segclip.toptexh;
                                 colfunc(column);
                                 ceilingclip[i] = (float)(column.y2 + 1);
@@ -431,11 +433,10 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                             column.y2 = b;
                             if(column.y2 >= column.y1)
                             {
-                                column.colormap =
-                                    R_calculateLighting(cmapcontext, segclip.walllights_bottom, segclip.dist);
-                                column.texmid = segclip.bottomtexmid;
-                                column.source =
-                                    R_GetRawColumn(heap, segclip.bottomtex, int(texx + segclip.toffset_bottom_x));
+                                column.colormap  = bottomlights[lightindex];
+                                column.texmid    = segclip.bottomtexmid;
+                                column.source    = R_GetRawColumn(heap, planecontext, segclip.bottomtex,
+                                                                  int(texx + segclip.toffset_bottom_x));
                                 column.texheight = segclip.bottomtexh;
                                 colfunc(column);
                                 floorclip[i] = (float)(column.y1 - 1);
@@ -461,14 +462,15 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
                     column.y1 = t;
                     column.y2 = b;
 
-                    column.colormap = R_calculateLighting(cmapcontext, segclip.walllights_mid, segclip.dist);
+                    column.colormap = midlights[lightindex];
                     column.texmid   = segclip.midtexmid;
                     if(segclip.skew_mid_step && (segclip.side->middleSkewType() == SKEW_FRONT_FLOOR ||
                                                  segclip.side->middleSkewType() == SKEW_FRONT_CEILING))
                         column.texmid += M_FloatToFixed(segclip.skew_mid_step * (segclip.len * basescale) +
                                                         segclip.skew_mid_baseoffset);
 
-                    column.source    = R_GetRawColumn(heap, segclip.midtex, int(texx + segclip.toffset_mid_x));
+                    column.source    = R_GetRawColumn(heap, planecontext, segclip.midtex,
+                                                      int(texx + segclip.toffset_mid_x));
                     column.texheight = segclip.midtexh;
 
                     colfunc(column);
@@ -500,14 +502,15 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
 
                     if(column.y2 >= column.y1)
                     {
-                        column.colormap = R_calculateLighting(cmapcontext, segclip.walllights_top, segclip.dist);
+                        column.colormap = toplights[lightindex];
                         column.texmid   = segclip.toptexmid;
 
                         if(segclip.skew_top_step && segclip.side->topSkewType() != SKEW_NONE)
                             column.texmid += M_FloatToFixed(segclip.skew_top_step * (segclip.len * basescale) +
                                                             segclip.skew_top_baseoffset);
 
-                        column.source    = R_GetRawColumn(heap, segclip.toptex, int(texx + segclip.toffset_top_x));
+                        column.source    = R_GetRawColumn(heap, planecontext, segclip.toptex,
+                                                          int(texx + segclip.toffset_top_x));
                         column.texheight = segclip.toptexh;
 
                         colfunc(column);
@@ -543,14 +546,15 @@ static void R_renderSegLoop(cmapcontext_t &cmapcontext, planecontext_t &planecon
 
                     if(column.y2 >= column.y1)
                     {
-                        column.colormap = R_calculateLighting(cmapcontext, segclip.walllights_bottom, segclip.dist);
+                        column.colormap = bottomlights[lightindex];
                         column.texmid   = segclip.bottomtexmid;
 
                         if(segclip.skew_bottom_step && segclip.side->bottomSkewType() != SKEW_NONE)
                             column.texmid += M_FloatToFixed(segclip.skew_bottom_step * (segclip.len * basescale) +
                                                             segclip.skew_bottom_baseoffset);
 
-                        column.source = R_GetRawColumn(heap, segclip.bottomtex, int(texx + segclip.toffset_bottom_x));
+                        column.source    = R_GetRawColumn(heap, planecontext, segclip.bottomtex,
+                                                          int(texx + segclip.toffset_bottom_x));
                         column.texheight = segclip.bottomtexh;
 
                         colfunc(column);
@@ -32,6 +32,7 @@
 struct camera_t;
 struct line_t;
 struct node_t;
+struct nodebbox_t;
 struct fnode_t;
 struct player_t;
 struct sector_t;
@@ -96,6 +97,8 @@ extern seg_t            *segs;
 extern int              numsectors;
 extern sector_t         *sectors;
 extern sectorinterp_t   *sectorinterps;
+extern int              *movedsectors;
+extern int               nummovedsectors;
 extern sectorbox_t      *pSectorBoxes;
 
 extern int              numsoundzones;
@@ -107,6 +110,7 @@ extern subsector_t      *subsectors;
 extern int              numnodes;
 extern node_t           *nodes;
 extern fnode_t          *fnodes;
+extern nodebbox_t       *nodebboxes;
 
 extern int              numlines;
 extern int              numlinesPlusExtra;
@@ -50,6 +50,7 @@
 #include "p_portalblockmap.h"
 #include "p_setup.h"
 #include "p_skin.h"
+#include "p_tick.h"
 #include "p_user.h"
 #include "r_bsp.h"
 #include "r_context.h"
@@ -338,6 +339,55 @@ void R_ClearBadSpritesAndFrames()
     }
 }
 
+// Sprites whose frames have all been baked for the masked drawers this level
+static byte *bakedsprites;
+
+//
+// R_BakeSprite
+//
+// Bakes every frame and rotation of a sprite for the masked drawers. Baking
+// allocates from the zone, so it's only done on the main thread while no
+// render context is running; the drawers then only read the results.
+//
+void R_BakeSprite(int sprnum)
+{
+    if(!bakedsprites)
+        bakedsprites = ecalloctag(byte *, numsprites, 1, PU_LEVEL, reinterpret_cast<void **>(&bakedsprites));
+    if(bakedsprites[sprnum])
+        return;
+    bakedsprites[sprnum] = 1;
+
+    const spritedef_t &sprdef = sprites[sprnum];
+    for(int i = 0; i < sprdef.numframes; i++)
+    {
+        const spriteframe_t &sprframe = sprdef.spriteframes[i];
+        if(sprframe.rotate == -1)
+            continue;
+
+        for(int rot = sprframe.rotate ? 7 : 0; rot >= 0; rot--)
+            PatchLoader::CacheMaskedNum(wGlobalDir, firstspritelump + sprframe.lump[rot]);
+    }
+}
+
+//
+// R_BakeThingSprites
+//
+// Bakes the sprites shown by things which haven't been baked yet, such as
+// those of things spawned since the level was precached. Called every frame
+// before the render contexts run.
+//
+void R_BakeThingSprites()
+{
+    for(Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        const Mobj *mo = thinker_cast<const Mobj *>(th);
+        if(!mo || (unsigned int)mo->sprite >= (unsigned int)numsprites)
+            continue; // bad sprite numbers are reported by R_ClearBadSpritesAndFrames
+        if(!bakedsprites || !bakedsprites[mo->sprite])
+            R_BakeSprite(mo->sprite);
+    }
+}
+
 //
 // R_SetMaskedSilhouette
 //
@@ -719,22 +769,23 @@ static vissprite_t *R_newVisSprite(spritecontext_t &context, ZoneHeap &heap)
 // Masked means: partly transparent, i.e. stored
 //  in posts/runs of opaque pixels.
 //
+// The runs come from the baked form of the patch (see maskedpatch_t), so
+// touching posts are drawn with a single call.
+//
 static void R_drawMaskedColumn(const R_ColumnFunc colfunc, cb_column_t &column, const cb_maskedcolumn_t &maskedcolumn,
-                               column_t *tcolumn, const float *const mfloorclip, const float *const mceilingclip)
+                               const maskedpatchcol_t &mcolumn, const float *const mfloorclip,
+                               const float *const mceilingclip)
 {
     float   y1, y2;
     fixed_t basetexturemid = column.texmid;
 
     column.texheight = 0; // killough 11/98
 
-    int top = 0;
-    while(tcolumn->topdelta != 0xff)
+    for(const maskedrun_t *run = mcolumn.runs, *end = run + mcolumn.numruns; run != end; ++run)
     {
-        top = tcolumn->topdelta <= top ? tcolumn->topdelta + top : tcolumn->topdelta;
-
-        // calculate unclipped screen coordinates for post
-        y1 = maskedcolumn.ytop + (maskedcolumn.scale * top);
-        y2 = y1 + (maskedcolumn.scale * tcolumn->length) - 1;
+        // calculate unclipped screen coordinates for run
+        y1 = maskedcolumn.ytop + (maskedcolumn.scale * run->top);
+        y2 = y1 + (maskedcolumn.scale * run->length) - 1;
 
         column.y1 = (int)(y1 < mceilingclip[column.x] ? mceilingclip[column.x] : y1);
         column.y2 = (int)(y2 > mfloorclip[column.x] ? mfloorclip[column.x] : y2);
@@ -742,13 +793,11 @@ static void R_drawMaskedColumn(const R_ColumnFunc colfunc, cb_column_t &column,
         // killough 3/2/98, 3/27/98: Failsafe against overflow/crash:
         if(column.y1 <= column.y2 && column.y2 < viewwindow.height)
         {
-            column.source = (byte *)tcolumn + 3;
-            column.texmid = basetexturemid - (top << FRACBITS);
+            column.source = run->source;
+            column.texmid = basetexturemid - (run->top << FRACBITS);
 
             colfunc(column);
         }
-
-        tcolumn = (column_t *)((byte *)tcolumn + tcolumn->length + 4);
     }
 
     column.texmid = basetexturemid;
@@ -885,13 +934,11 @@ void R_DrawNewMaskedColumn(const R_ColumnFunc colfunc, cb_column_t &column, cons
 static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis, float *const mfloorclip,
                             float *const mceilingclip)
 {
-    column_t *tcolumn;
-    int       texturecolumn;
-    float     frac;
-    patch_t  *patch;
-    bool      footclipon = false;
-    float     baseclip   = 0;
-    int       w;
+    int                  texturecolumn;
+    float                frac;
+    const maskedpatch_t *patch;
+    bool                 footclipon = false;
+    float                baseclip   = 0;
 
     cb_column_t column{};
 
@@ -902,7 +949,12 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis, flo
         return;
     }
 
-    patch = PatchLoader::CacheNum(wGlobalDir, vis->patch + firstspritelump, PU_CACHE);
+    // baked on the main thread by R_BakeSprite before the contexts run
+    patch = PatchLoader::GetMaskedNum(wGlobalDir, vis->patch + firstspritelump);
+
+    // nothing to draw in a fully transparent patch
+    if(!patch || patch->firstcolumn > patch->lastcolumn)
+        return;
 
     column.colormap = vis->colormap;
 
@@ -936,7 +988,10 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis, flo
         baseclip   = vis->ybottom - M_FixedToFloat(vis->footclip) * vis->scale;
     }
 
-    w = patch->width;
+    // columns outside this range are empty, so they are skipped along with
+    // out-of-range ones
+    const int firstcol = patch->firstcolumn;
+    const int lastcol  = patch->lastcolumn;
 
     // haleyjd: use a separate loop for footclip things, to minimize
     // overhead for regular sprites and to require no separate loop
@@ -954,11 +1009,11 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis, flo
             texturecolumn = (int)frac;
 
             // haleyjd 09/16/07: Cardboard requires this rangecheck, made nonfatal
-            if(texturecolumn < 0 || texturecolumn >= w)
+            if(texturecolumn < firstcol || texturecolumn > lastcol)
                 continue;
 
-            tcolumn = (column_t *)((byte *)patch + patch->columnofs[texturecolumn]);
-            R_drawMaskedColumn(colfunc, column, maskedcolumn, tcolumn, mfloorclip, mceilingclip);
+            R_drawMaskedColumn(colfunc, column, maskedcolumn, patch->columns[texturecolumn], mfloorclip,
+                               mceilingclip);
         }
     }
     else
@@ -968,11 +1023,11 @@ static void R_drawVisSprite(const contextbounds_t &bounds, vissprite_t *vis, flo
             texturecolumn = (int)frac;
 
             // haleyjd 09/16/07: Cardboard requires this rangecheck, made nonfatal
-            if(texturecolumn < 0 || texturecolumn >= w)
+            if(texturecolumn < firstcol || texturecolumn > lastcol)
                 continue;
 
-            tcolumn = (column_t *)((byte *)patch + patch->columnofs[texturecolumn]);
-            R_drawMaskedColumn(colfunc, column, maskedcolumn, tcolumn, mfloorclip, mceilingclip);
+            R_drawMaskedColumn(colfunc, column, maskedcolumn, patch->columns[texturecolumn], mfloorclip,
+                               mceilingclip);
         }
     }
 }
@@ -1633,6 +1688,9 @@ static void R_drawPSprite(const pspdef_t *psp, const lighttable_t *const *const
     lump = sprframe->lump[0];
     flip = !!(sprframe->flip[0] ^ lefthanded);
 
+    // player sprites are drawn on the main thread, so they can be baked here
+    PatchLoader::CacheMaskedNum(wGlobalDir, lump + firstspritelump);
+
     // calculate edges of the shape
     v2fixed_t pspos;
     R_interpolatePSpritePosition(*psp, pspos);
@@ -2219,8 +2277,8 @@ void R_DrawPostBSP(rendercontext_t &context)
             if(r_column_engine->ResetBuffer)
                 r_column_engine->ResetBuffer();
 
-            R_DrawPlanes(context.cmapcontext, *context.heap, planecontext.mainhash, planecontext.spanstart,
-                         context.view.angle, pstack[pstacksize].overlay);
+            R_DrawPlanes(context.cmapcontext, *context.heap, planecontext, context.view.angle,
+                         pstack[pstacksize].overlay);
             R_FreeOverlaySet(planecontext.r_overlayfreesets, pstack[pstacksize].overlay);
         }
     }
@@ -73,6 +73,8 @@ void R_PushPost(bspcontext_t &bspcontext, spritecontext_t &spritecontext, ZoneHe
                 bool pushmasked, pwindow_t *window);
 
 void R_ClearBadSpritesAndFrames();
+void R_BakeSprite(int sprnum);
+void R_BakeThingSprites();
 
 // SoM: Cardboard
 void R_SetMaskedSilhouette(const contextbounds_t &bounds, const float *top, const float *bottom);
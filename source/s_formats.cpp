@@ -24,6 +24,13 @@
 // Authors: James Haley, Max Waine, Alison Gray Watson
 //
 
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #include "z_zone.h"
 
 #include "doomtype.h"
@@ -31,6 +38,7 @@
 #include "m_binary.h"
 #include "m_compare.h"
 #include "m_swap.h"
+#include "s_formats.h"
 #include "s_sound.h"
 #include "w_wad.h"
 
@@ -302,6 +310,71 @@ static bool S_detectSoundFormat(sounddata_t &sd, byte *data, size_t len)
     return false;
 }
 
+//=============================================================================
+//
+// Sample Pool
+//
+// Converted samples are kept until the sound cache is flushed, never one by
+// one, so they're carved out of large slabs instead of getting a zone block
+// each. The pool is locked because the decoding workers allocate from it.
+//
+
+static constexpr size_t SOUNDSLABSIZE = 1024 * 1024;
+
+static std::mutex          soundpoolmutex;
+static std::vector<byte *> soundslabs;
+static byte               *soundslabptr;
+static size_t              soundslabfree;
+
+//
+// S_poolAlloc
+//
+// Allocates storage for converted samples.
+//
+static float *S_poolAlloc(size_t count)
+{
+    const size_t size = (count * sizeof(float) + 15) & ~size_t(15);
+
+    std::lock_guard<std::mutex> lock(soundpoolmutex);
+
+    // big samples get a slab of their own
+    if(size > SOUNDSLABSIZE / 4)
+    {
+        byte *slab = static_cast<byte *>(Z_SysMalloc(size));
+        soundslabs.push_back(slab);
+        return reinterpret_cast<float *>(slab);
+    }
+
+    if(size > soundslabfree)
+    {
+        soundslabptr  = static_cast<byte *>(Z_SysMalloc(SOUNDSLABSIZE));
+        soundslabfree = SOUNDSLABSIZE;
+        soundslabs.push_back(soundslabptr);
+    }
+
+    float *ret     = reinterpret_cast<float *>(soundslabptr);
+    soundslabptr  += size;
+    soundslabfree -= size;
+    return ret;
+}
+
+//
+// S_FreeSoundSamples
+//
+// Frees every converted sample at once. Every sound's data pointer must be
+// cleared, and no decodes may be pending.
+//
+void S_FreeSoundSamples()
+{
+    std::lock_guard<std::mutex> lock(soundpoolmutex);
+
+    for(byte *slab : soundslabs)
+        Z_SysFree(slab);
+    soundslabs.clear();
+    soundslabptr  = nullptr;
+    soundslabfree = 0;
+}
+
 //=============================================================================
 //
 // PCM Conversion
@@ -325,24 +398,24 @@ static unsigned int S_alenForSample(const sounddata_t &sd)
 //
 // Convert unsigned 8-bit PCM to double precision floating point.
 //
-static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
+static float *S_convertPCMU8(const sounddata_t &sd, unsigned int &alen)
 {
-    sfx->alen = S_alenForSample(sd);
-    sfx->data = Z_Malloc(sfx->alen * sizeof(float), PU_STATIC, &sfx->data);
+    alen        = S_alenForSample(sd);
+    float *data = S_poolAlloc(alen);
 
     // haleyjd 12/18/13: Convert sound to target samplerate and into floating
     // point samples.
-    if(sfx->alen != sd.samplecount)
+    if(alen != sd.samplecount)
     {
         unsigned int i;
-        float       *dest = static_cast<float *>(sfx->data);
+        float       *dest = data;
         byte        *src  = sd.samplestart;
 
         unsigned int step          = (sd.samplerate << 16) / TARGETSAMPLERATE;
         unsigned int stepremainder = 0, j = 0;
 
         // do linear filtering operation
-        for(i = 0; i < sfx->alen && j < sd.samplecount - 1; i++)
+        for(i = 0; i < alen && j < sd.samplecount - 1; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int k = 0; k < sd.channels; k++)
@@ -361,7 +434,7 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
             stepremainder &= 0xffff;
         }
         // fill remainder (if any) with final sample byte
-        for(; i < sfx->alen; i++)
+        for(; i < alen; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int k = 0; k < sd.channels; k++)
@@ -373,10 +446,10 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
     else
     {
         // sound is already at target samplerate, just convert to doubles
-        float *dest = static_cast<float *>(sfx->data);
+        float *dest = data;
         byte  *src  = sd.samplestart;
 
-        for(unsigned int i = 0; i < sfx->alen; i++)
+        for(unsigned int i = 0; i < alen; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int j = 0; j < sd.channels; j++)
@@ -385,6 +458,8 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
                 dest[i] /= sd.channels;
         }
     }
+
+    return data;
 }
 
 //
@@ -392,24 +467,24 @@ static void S_convertPCMU8(sfxinfo_t *sfx, const sounddata_t &sd)
 //
 // Convert signed 16-bit PCM to double precision floating point.
 //
-static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
+static float *S_convertPCM16(const sounddata_t &sd, unsigned int &alen)
 {
-    sfx->alen = S_alenForSample(sd);
-    sfx->data = Z_Malloc(sfx->alen * sizeof(float), PU_STATIC, &sfx->data);
+    alen        = S_alenForSample(sd);
+    float *data = S_poolAlloc(alen);
 
     // haleyjd 12/18/13: Convert sound to target samplerate and into floating
     // point samples.
-    if(sfx->alen != sd.samplecount)
+    if(alen != sd.samplecount)
     {
         unsigned int i;
-        float       *dest = static_cast<float *>(sfx->data);
+        float       *dest = data;
         int16_t     *src  = reinterpret_cast<int16_t *>(sd.samplestart);
 
         unsigned int step          = (sd.samplerate << 16) / TARGETSAMPLERATE;
         unsigned int stepremainder = 0, j = 0;
 
         // do linear filtering operation
-        for(i = 0; i < sfx->alen && j < sd.samplecount - 1; i++)
+        for(i = 0; i < alen && j < sd.samplecount - 1; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int k = 0; k < sd.channels; k++)
@@ -429,7 +504,7 @@ static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
             stepremainder &= 0xffff;
         }
         // fill remainder (if any) with final sample byte
-        for(; i < sfx->alen; i++)
+        for(; i < alen; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int k = 0; k < sd.channels; k++)
@@ -444,10 +519,10 @@ static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
     else
     {
         // sound is already at target samplerate, just convert to doubles
-        float   *dest = static_cast<float *>(sfx->data);
+        float   *dest = data;
         int16_t *src  = reinterpret_cast<int16_t *>(sd.samplestart);
 
-        for(unsigned int i = 0; i < sfx->alen; i++)
+        for(unsigned int i = 0; i < alen; i++)
         {
             dest[i] = 0.0f;
             for(unsigned int j = 0; j < sd.channels; j++)
@@ -459,6 +534,8 @@ static void S_convertPCM16(sfxinfo_t *sfx, const sounddata_t &sd)
                 dest[i] /= sd.channels;
         }
     }
+
+    return data;
 }
 
 //=============================================================================
@@ -489,78 +566,293 @@ static int S_getSfxLumpNum(sfxinfo_t *sfx)
     return wGlobalDir.checkNumForNameNSG(namebuf, lumpinfo_t::ns_sounds);
 }
 
-//=============================================================================
 //
-// Interface
+// S_decodeSound
+//
+// Detects the format of a sound lump and converts it to float samples at the
+// output rate. Touches nothing but its arguments and the sample pool, so it
+// can run on a decoding worker. Returns nullptr if the format isn't supported.
 //
+static float *S_decodeSound(byte *lumpdata, size_t lumplen, unsigned int &alen)
+{
+    sounddata_t sd = {};
+
+    if(!S_detectSoundFormat(sd, lumpdata, lumplen))
+        return nullptr;
+
+    switch(sd.fmt)
+    {
+    case S_FMT_U8: //
+        return S_convertPCMU8(sd, alen);
+    case S_FMT_16: //
+        return S_convertPCM16(sd, alen);
+    default: // unsupported PCM format
+        return nullptr;
+    }
+}
 
 //
-// S_LoadDigitalSoundEffect
+// S_soundLump
 //
-// Function to load supported digital sound effects from the WadDirectory.
-// Returns true if sound is loaded and ready to play; false otherwise.
+// Finds the lump for a sound, substituting the default sound if it's missing.
 //
-bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx)
+static int S_soundLump(sfxinfo_t *sfx)
 {
-    bool res  = false;
-    int  lump = S_getSfxLumpNum(sfx);
+    int lump = S_getSfxLumpNum(sfx);
 
     // replace missing sounds with a reasonable default
     if(lump == -1)
         lump = wGlobalDir.getNumForNameNSG(GameModeInfo->defSoundName, lumpinfo_t::ns_sounds);
 
-    size_t lumplen = (size_t)wGlobalDir.lumpLength(lump);
-    if(!lumplen)
-        return false;
+    return lump;
+}
+
+//=============================================================================
+//
+// Background Decoding
+//
+// Sounds known to be needed soon (everything, if s_precache is on, and the
+// sounds of the things on a map at level load) are decoded by a small pool of
+// workers. The lump is cached by the main thread and held static until the
+// job is collected, so the workers never touch the zone heap or the wad
+// files. A sound played before its job finishes takes the job back and
+// decodes it on the spot, or waits for the worker already busy with it.
+//
+
+enum sounddecodestate_e
+{
+    SDS_QUEUED,  // waiting for a worker
+    SDS_RUNNING, // being decoded
+    SDS_DONE     // decoded, waiting to be collected
+};
+
+struct sounddecode_t
+{
+    sfxinfo_t         *sfx;
+    byte              *lumpdata;
+    size_t             lumplen;
+    sounddecodestate_e state;
+    float             *data;
+    unsigned int       alen;
+};
+
+static std::mutex                  decodemutex;
+static std::condition_variable     decodewake; // work was queued, or quit
+static std::condition_variable     decodedone; // a job finished
+static std::deque<sounddecode_t *> decodequeue;
+static std::vector<std::thread>    decodethreads;
+static bool                        decodequit;
+
+// jobs not yet collected; main thread only
+static std::vector<sounddecode_t *> decodepending;
+
+//
+// S_decodeThreadFunc
+//
+static void S_decodeThreadFunc()
+{
+    std::unique_lock<std::mutex> lock(decodemutex);
 
-    if(!sfx->data)
+    while(true)
     {
-        sounddata_t sd       = {};
-        byte       *lumpdata = (byte *)wGlobalDir.cacheLumpNum(lump, PU_STATIC);
+        decodewake.wait(lock, [] { return decodequit || !decodequeue.empty(); });
+        if(decodequit)
+            return;
+
+        sounddecode_t *job = decodequeue.front();
+        decodequeue.pop_front();
+        job->state = SDS_RUNNING;
+
+        lock.unlock();
+        job->data = S_decodeSound(job->lumpdata, job->lumplen, job->alen);
+        lock.lock();
 
-        if(S_detectSoundFormat(sd, lumpdata, lumplen))
+        job->state = SDS_DONE;
+        decodedone.notify_all();
+    }
+}
+
+//
+// S_startDecodeThreads
+//
+static void S_startDecodeThreads()
+{
+    if(!decodethreads.empty())
+        return;
+
+    // leave a core for the game
+    const unsigned int numthreads = eclamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+
+    decodequit = false;
+    for(unsigned int i = 0; i < numthreads; i++)
+        decodethreads.emplace_back(S_decodeThreadFunc);
+}
+
+//
+// S_collectDecode
+//
+// Hands a job's result to its sound and releases the job. If wait is true,
+// the job is finished first; otherwise unfinished jobs are left alone and
+// false is returned.
+//
+static bool S_collectDecode(sounddecode_t *job, bool wait)
+{
+    {
+        std::unique_lock<std::mutex> lock(decodemutex);
+
+        if(job->state == SDS_QUEUED)
         {
-            switch(sd.fmt)
-            {
-            case S_FMT_U8:
-                S_convertPCMU8(sfx, sd);
-                res = true;
-                break;
-            case S_FMT_16:
-                S_convertPCM16(sfx, sd);
-                res = true;
-                break;
-            default: // unsupported PCM format
-                break;
-            }
+            if(!wait)
+                return false;
+
+            // needed now: take it back from the queue and decode it here
+            decodequeue.erase(std::find(decodequeue.begin(), decodequeue.end(), job));
+            lock.unlock();
+            job->data  = S_decodeSound(job->lumpdata, job->lumplen, job->alen);
+            job->state = SDS_DONE;
         }
+        else if(job->state == SDS_RUNNING)
+        {
+            if(!wait)
+                return false;
+            decodedone.wait(lock, [job] { return job->state == SDS_DONE; });
+        }
+    }
 
-        // haleyjd 06/03/06: don't need original lump data any more if loaded
-        Z_ChangeTag(lumpdata, PU_CACHE);
+    sfxinfo_t *sfx = job->sfx;
+    if(job->data)
+    {
+        sfx->data = job->data;
+        sfx->alen = job->alen;
     }
-    else
+    sfx->decode = nullptr;
+
+    // haleyjd 06/03/06: don't need original lump data any more if loaded
+    Z_ChangeTag(job->lumpdata, PU_CACHE);
+    efree(job);
+    return true;
+}
+
+//
+// S_QueueSoundDecode
+//
+// Queues a sound to be decoded in the background, unless it's already
+// decoded or queued.
+//
+void S_QueueSoundDecode(sfxinfo_t *sfx)
+{
+    if(sfx->data || sfx->decode)
+        return;
+
+    const int    lump    = S_soundLump(sfx);
+    const size_t lumplen = size_t(wGlobalDir.lumpLength(lump));
+    if(!lumplen)
+        return;
+
+    sounddecode_t *job = estructalloc(sounddecode_t, 1);
+    job->sfx           = sfx;
+    job->lumpdata      = static_cast<byte *>(wGlobalDir.cacheLumpNum(lump, PU_STATIC));
+    job->lumplen       = lumplen;
+    job->state         = SDS_QUEUED;
+    sfx->decode        = job;
+    decodepending.push_back(job);
+
+    S_startDecodeThreads();
+
+    std::lock_guard<std::mutex> lock(decodemutex);
+    decodequeue.push_back(job);
+    decodewake.notify_one();
+}
+
+//
+// S_UpdateSoundDecodes
+//
+// Collects finished background decodes. Called every sound update.
+//
+void S_UpdateSoundDecodes()
+{
+    size_t kept = 0;
+
+    for(sounddecode_t *job : decodepending)
+        if(!S_collectDecode(job, false))
+            decodepending[kept++] = job;
+
+    decodepending.resize(kept);
+}
+
+//
+// S_FinishSoundDecodes
+//
+// Waits for or performs every queued decode.
+//
+void S_FinishSoundDecodes()
+{
+    for(sounddecode_t *job : decodepending)
+        S_collectDecode(job, true);
+
+    decodepending.clear();
+}
+
+//
+// S_ShutdownSoundDecoding
+//
+// Stops the decoding workers.
+//
+void S_ShutdownSoundDecoding()
+{
     {
-        Z_ChangeTag(sfx->data, PU_STATIC); // mark as in-use
-        res = true;
+        std::lock_guard<std::mutex> lock(decodemutex);
+        decodequit = true;
+        decodewake.notify_all();
     }
 
-    return res;
+    for(std::thread &thread : decodethreads)
+        thread.join();
+    decodethreads.clear();
 }
 
+//=============================================================================
 //
-// S_CacheDigitalSoundLump
+// Interface
 //
-// Invoke when caching sound lumps at startup or after a wad load.
+
+//
+// S_LoadDigitalSoundEffect
 //
-void S_CacheDigitalSoundLump(sfxinfo_t *sfx)
+// Function to load supported digital sound effects from the WadDirectory.
+// Returns true if sound is loaded and ready to play; false otherwise.
+//
+bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx)
 {
-    int lump = S_getSfxLumpNum(sfx);
+    // finish a background decode now if it isn't done yet
+    if(sfx->decode)
+    {
+        sounddecode_t *job = sfx->decode;
+        S_collectDecode(job, true);
+        decodepending.erase(std::find(decodepending.begin(), decodepending.end(), job));
+    }
 
-    // replace missing sounds with a reasonable default
-    if(lump == -1)
-        lump = wGlobalDir.getNumForNameNSG(GameModeInfo->defSoundName, lumpinfo_t::ns_sounds);
+    if(sfx->data)
+        return true;
+
+    const int    lump    = S_soundLump(sfx);
+    const size_t lumplen = size_t(wGlobalDir.lumpLength(lump));
+    if(!lumplen)
+        return false;
+
+    byte *lumpdata = static_cast<byte *>(wGlobalDir.cacheLumpNum(lump, PU_STATIC));
+
+    unsigned int alen = 0;
+    if(float *data = S_decodeSound(lumpdata, lumplen, alen))
+    {
+        sfx->data = data;
+        sfx->alen = alen;
+    }
+
+    // haleyjd 06/03/06: don't need original lump data any more if loaded
+    Z_ChangeTag(lumpdata, PU_CACHE);
 
-    wGlobalDir.cacheLumpNum(lump, PU_CACHE);
+    return sfx->data != nullptr;
 }
 
 // EOF
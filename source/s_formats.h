@@ -30,7 +30,13 @@
 struct sfxinfo_t;
 
 bool S_LoadDigitalSoundEffect(sfxinfo_t *sfx);
-void S_CacheDigitalSoundLump(sfxinfo_t *sfx);
+
+// Background decoding
+void S_QueueSoundDecode(sfxinfo_t *sfx);
+void S_UpdateSoundDecodes();
+void S_FinishSoundDecodes();
+void S_ShutdownSoundDecoding();
+void S_FreeSoundSamples();
 
 #endif
 
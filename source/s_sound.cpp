@@ -39,6 +39,7 @@
 #include "e_sound.h"
 #include "i_sound.h"
 #include "i_system.h"
+#include "m_collection.h"
 #include "m_compare.h"
 #include "m_random.h"
 #include "m_queue.h"
@@ -51,6 +52,7 @@
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_state.h"
+#include "s_formats.h"
 #include "s_reverb.h"
 #include "s_sound.h"
 #include "v_misc.h"
@@ -94,11 +96,36 @@ struct channel_t
     int                 singularity; // haleyjd 09/27/06: stored singularity value
     int                 idnum;       // haleyjd 09/30/06: unique id num for sound event
     bool                looping;     // haleyjd 10/06/06: is this channel looping?
+    bool                reverb;      // whether the sound goes through reverb
 };
 
 // the set of channels available
 static channel_t *channels;
 
+//
+// A logical sound instance. Looping sounds that are inaudible, or that lose
+// their channel to something more important, are kept as virtual voices and
+// re-evaluated every update so they can take a channel back once they win
+// one. Only the channels are mixed; virtual voices cost a distance check.
+//
+struct virtualvoice_t
+{
+    sfxinfo_t          *sfxinfo;
+    sfxinfo_t          *aliasinfo;
+    const PointThinker *origin;
+    int                 subchannel;
+    int                 volume; // volume scale
+    int                 attenuation;
+    int                 pitch;
+    int                 o_priority;
+    int                 singularity;
+    bool                reverb;
+};
+
+static constexpr size_t MAXVIRTUALVOICES = 4096;
+
+static PODCollection<virtualvoice_t> virtualvoices;
+
 // Maximum volume of a sound effect.
 // Internal default is max out of 0-SND_MAXVOLUME.
 int snd_SfxVolume = SND_MAXVOLUME;
@@ -161,6 +188,110 @@ static void S_StopChannel(int cnum)
     }
 }
 
+//
+// S_addVirtualVoice
+//
+// Keeps track of a looping sound that isn't being mixed.
+//
+static void S_addVirtualVoice(const virtualvoice_t &voice)
+{
+    if(virtualvoices.getLength() < MAXVIRTUALVOICES)
+        virtualvoices.add(voice);
+}
+
+//
+// S_removeVirtualVoices
+//
+// Drops the virtual voices matching the predicate, keeping the order of the
+// rest.
+//
+template<typename F> static void S_removeVirtualVoices(F &&match)
+{
+    size_t kept = 0;
+
+    for(size_t i = 0; i < virtualvoices.getLength(); i++)
+        if(!match(virtualvoices[i]))
+            virtualvoices[kept++] = virtualvoices[i];
+
+    virtualvoices.resize(kept);
+}
+
+//
+// S_virtualizeChannel
+//
+// Stops a channel, keeping its sound as a virtual voice if it loops.
+//
+static void S_virtualizeChannel(int cnum)
+{
+    const channel_t &c = channels[cnum];
+
+    if(c.sfxinfo && c.looping)
+    {
+        virtualvoice_t voice;
+        voice.sfxinfo     = c.sfxinfo;
+        voice.aliasinfo   = c.aliasinfo;
+        voice.origin      = c.origin;
+        voice.subchannel  = c.subchannel;
+        voice.volume      = c.volume;
+        voice.attenuation = c.attenuation;
+        voice.pitch       = c.pitch;
+        voice.o_priority  = c.o_priority;
+        voice.singularity = c.singularity;
+        voice.reverb      = c.reverb;
+        S_addVirtualVoice(voice);
+    }
+
+    S_StopChannel(cnum);
+}
+
+//
+// S_startChannel
+//
+// Starts a sound on a free channel. Returns false if the sound couldn't
+// be started.
+//
+static bool S_startChannel(int cnum, const virtualvoice_t &voice, bool loop, int volume, int sep, int priority)
+{
+    sfxinfo_t *sfx = voice.sfxinfo;
+
+    channels[cnum].sfxinfo   = sfx;
+    channels[cnum].aliasinfo = voice.aliasinfo;
+    channels[cnum].origin    = voice.origin;
+
+    while(sfx->link)
+        sfx = sfx->link; // sf: skip thru link(s)
+
+    // Assigns the handle to one of the channels in the mix/output buffer.
+    const int handle = I_StartSound(sfx, cnum, volume, sep, voice.pitch, priority, loop, voice.reverb);
+
+    // haleyjd: check to see if the sound was started
+    if(handle < 0)
+    {
+        // haleyjd: the sound didn't start, so clear the channel info
+        memset(&channels[cnum], 0, sizeof(channel_t));
+        return false;
+    }
+
+    channels[cnum].handle = handle;
+
+    // haleyjd 05/29/06: record volume scale value and attenuation type
+    // haleyjd 06/03/06: record pitch too (wtf is going on here??)
+    // haleyjd 09/27/06: store priority and singularity values (!!!)
+    // haleyjd 06/12/08: store subchannel
+    channels[cnum].volume      = voice.volume;
+    channels[cnum].attenuation = voice.attenuation;
+    channels[cnum].pitch       = voice.pitch;
+    channels[cnum].o_priority  = voice.o_priority; // original priority
+    channels[cnum].priority    = priority;         // scaled priority
+    channels[cnum].singularity = voice.singularity;
+    channels[cnum].looping     = loop;
+    channels[cnum].reverb      = voice.reverb;
+    channels[cnum].subchannel  = voice.subchannel;
+    channels[cnum].idnum       = I_SoundID(handle); // unique instance id
+
+    return true;
+}
+
 //
 // S_CheckSectorKill
 //
@@ -381,7 +512,7 @@ static int S_getChannel(const PointThinker *origin, sfxinfo_t *sfxinfo, int prio
             return -1; // No lower priority.  Sorry, Charlie.
         else
         {
-            S_StopChannel(lpcnum); // Otherwise, kick out lowest priority.
+            S_virtualizeChannel(lpcnum); // Otherwise, kick out lowest priority.
             cnum = lpcnum;
         }
     }
@@ -421,13 +552,14 @@ static int S_countChannels()
 //
 void S_StartSfxInfo(const soundparams_t &params)
 {
-    int                 sep            = 0, pitch, singularity, cnum, handle, o_priority, priority, chancount;
+    int                 sep            = 0, pitch, singularity, cnum, o_priority, priority, chancount;
     int                 volume         = snd_SfxVolume;
     int                 volumeScale    = params.volumeScale;
     int                 subchannel     = params.subchannel;
     bool                priority_boost = false;
     bool                extcamera      = false;
     bool                nocutoff       = false;
+    bool                audible        = true;
     camera_t            playercam;
     camera_t           *listener = &playercam;
     sector_t           *earsec   = nullptr;
@@ -575,9 +707,14 @@ void S_StartSfxInfo(const soundparams_t &params)
     else
     {
         // use an external cam?
+        // looping sounds out of earshot are kept as virtual voices
         if(!S_AdjustSoundParams(listener, origin, volumeScale, params.attenuation, &volume, &sep, &pitch, &priority,
                                 sfx))
-            return;
+        {
+            if(!params.loop)
+                return;
+            audible = false;
+        }
         else if(origin->x == playercam.x && origin->y == playercam.y)
             sep = NORM_SEP;
     }
@@ -613,48 +750,48 @@ void S_StartSfxInfo(const soundparams_t &params)
     if(subchannel == CHAN_AUTO)
         subchannel = sfx->subchannel;
 
+    virtualvoice_t voice;
+    voice.sfxinfo     = sfx;
+    voice.aliasinfo   = aliasinfo;
+    voice.origin      = origin;
+    voice.subchannel  = subchannel;
+    voice.volume      = volumeScale;
+    voice.attenuation = params.attenuation;
+    voice.pitch       = pitch;
+    voice.o_priority  = o_priority;
+    voice.singularity = singularity;
+    voice.reverb      = params.reverb;
+
+    // a new sound replaces a virtual one the same way it would a playing one
+    if(!nocutoff && virtualvoices.getLength())
+    {
+        S_removeVirtualVoices([&voice](const virtualvoice_t &v) {
+            return v.singularity == voice.singularity && v.subchannel == voice.subchannel &&
+                   (voice.origin ? v.origin == voice.origin : v.sfxinfo == voice.sfxinfo);
+        });
+    }
+
+    if(!audible)
+    {
+        S_addVirtualVoice(voice);
+        return;
+    }
+
     // try to find a channel
     if((cnum = S_getChannel(origin, sfx, priority, singularity, subchannel, nocutoff)) < 0)
+    {
+        if(params.loop)
+            S_addVirtualVoice(voice);
         return;
+    }
 
 #ifdef RANGECHECK
     if(cnum < 0 || cnum >= numChannels)
         I_Error("S_StartSfxInfo: handle %d out of range\n", cnum);
 #endif
 
-    channels[cnum].sfxinfo   = sfx;
-    channels[cnum].aliasinfo = aliasinfo;
-    channels[cnum].origin    = origin;
-
-    while(sfx->link)
-        sfx = sfx->link; // sf: skip thru link(s)
-
-    // Assigns the handle to one of the channels in the mix/output buffer.
-    handle = I_StartSound(sfx, cnum, volume, sep, pitch, priority, params.loop, params.reverb);
-
-    // haleyjd: check to see if the sound was started
-    if(handle >= 0)
-    {
-        channels[cnum].handle = handle;
-
-        // haleyjd 05/29/06: record volume scale value and attenuation type
-        // haleyjd 06/03/06: record pitch too (wtf is going on here??)
-        // haleyjd 09/27/06: store priority and singularity values (!!!)
-        // haleyjd 06/12/08: store subchannel
-        channels[cnum].volume      = volumeScale;
-        channels[cnum].attenuation = params.attenuation;
-        channels[cnum].pitch       = pitch;
-        channels[cnum].o_priority  = o_priority; // original priority
-        channels[cnum].priority    = priority;   // scaled priority
-        channels[cnum].singularity = singularity;
-        channels[cnum].looping     = params.loop;
-        channels[cnum].subchannel  = subchannel;
-        channels[cnum].idnum       = I_SoundID(handle); // unique instance id
-    }
-    else // haleyjd: the sound didn't start, so clear the channel info
-    {
-        memset(&channels[cnum], 0, sizeof(channel_t));
-    }
+    if(!S_startChannel(cnum, voice, params.loop, volume, sep, priority) && params.loop)
+        S_addVirtualVoice(voice);
 }
 
 //
@@ -827,6 +964,13 @@ void S_StopSound(const PointThinker *origin, int subchannel)
             S_StopChannel(cnum);
         }
     }
+
+    if(virtualvoices.getLength())
+    {
+        S_removeVirtualVoices([origin, subchannel](const virtualvoice_t &v) {
+            return v.origin == origin && (subchannel == CHAN_ALL || v.subchannel == subchannel);
+        });
+    }
 }
 
 //
@@ -849,6 +993,13 @@ void S_StopSoundId(const PointThinker *origin, int sound_id)
             S_StopChannel(cnum);
         }
     }
+
+    if(virtualvoices.getLength())
+    {
+        S_removeVirtualVoices([origin, sound_id](const virtualvoice_t &v) {
+            return v.origin == origin && v.aliasinfo && v.aliasinfo->dehackednum == sound_id;
+        });
+    }
 }
 
 //
@@ -903,6 +1054,87 @@ static void S_updateEnvironment(sector_t *earsec)
     }
 }
 
+//
+// S_findVoiceChannel
+//
+// Finds a free channel for a virtual voice of the given priority, or else the
+// least important playing channel if the voice beats it. Returns -1 if there
+// is none.
+//
+static int S_findVoiceChannel(int priority)
+{
+    int lowestpriority = D_MININT;
+    int lpcnum         = -1;
+
+    for(int cnum = 0; cnum < numChannels; cnum++)
+    {
+        if(!channels[cnum].sfxinfo)
+            return cnum;
+        if(channels[cnum].priority > lowestpriority)
+        {
+            lowestpriority = channels[cnum].priority;
+            lpcnum         = cnum;
+        }
+    }
+
+    return priority < lowestpriority ? lpcnum : -1;
+}
+
+//
+// S_updateVirtualVoices
+//
+// Re-evaluates every virtual voice against the listener and gives a channel
+// back to each one that is audible and either finds a free channel or is more
+// important than the least important playing sound. The cost is one pass
+// over the virtual voices.
+//
+static void S_updateVirtualVoices(camera_t *listener, const sector_t *earsec)
+{
+    const size_t count = virtualvoices.getLength();
+    bool         promoted = false;
+
+    if(!count || (earsec && earsec->flags & SECF_KILLSOUND))
+        return;
+
+    for(size_t i = 0; i < count; i++)
+    {
+        // copied, since bumping a channel may grow the collection
+        const virtualvoice_t voice = virtualvoices[i];
+
+        int volume = snd_SfxVolume;
+        int pitch  = voice.pitch;
+        int sep    = NORM_SEP;
+        int pri    = voice.o_priority;
+
+        if(voice.origin)
+        {
+            if(!S_AdjustSoundParams(listener, voice.origin, voice.volume, voice.attenuation, &volume, &sep, &pitch,
+                                    &pri, voice.sfxinfo))
+            {
+                continue;
+            }
+        }
+        else if((volume = (volume * voice.volume) / SND_MAXVOLUME) < 1)
+            continue;
+
+        const int cnum = S_findVoiceChannel(pri);
+        if(cnum < 0 || S_CheckSectorKill(nullptr, voice.origin))
+            continue;
+
+        if(channels[cnum].sfxinfo)
+            S_virtualizeChannel(cnum);
+
+        if(S_startChannel(cnum, voice, true, volume, sep, pri))
+        {
+            virtualvoices[i].sfxinfo = nullptr;
+            promoted                 = true;
+        }
+    }
+
+    if(promoted)
+        S_removeVirtualVoices([](const virtualvoice_t &v) { return !v.sfxinfo; });
+}
+
 //
 // S_UpdateSounds
 //
@@ -918,6 +1150,9 @@ void S_UpdateSounds(const Mobj *listener)
     if(!snd_card || nosfxparm)
         return;
 
+    // hand off sounds decoded in the background
+    S_UpdateSoundDecodes();
+
     if(listener)
     {
         // haleyjd 08/12/04: fix possible bugs with external cameras
@@ -984,7 +1219,7 @@ void S_UpdateSounds(const Mobj *listener)
                 if(!S_AdjustSoundParams(listener ? &playercam : nullptr, c->origin, c->volume, c->attenuation, &volume,
                                         &sep, &pitch, &pri, sfx))
                 {
-                    S_StopChannel(cnum);
+                    S_virtualizeChannel(cnum);
                 }
                 else
                 {
@@ -996,6 +1231,9 @@ void S_UpdateSounds(const Mobj *listener)
         else // if channel is allocated but sound has stopped, free it
             S_StopChannel(cnum);
     }
+
+    if(listener)
+        S_updateVirtualVoices(&playercam, earsec);
 }
 
 //
@@ -1017,6 +1255,11 @@ bool S_CheckSoundPlaying(const PointThinker *mo, sfxinfo_t *aliasinfo)
                     return true;
             }
         }
+
+        // a looping sound that's out of earshot is still playing
+        for(const virtualvoice_t &voice : virtualvoices)
+            if(voice.origin == mo && voice.aliasinfo == aliasinfo)
+                return true;
     }
 
     return false;
@@ -1034,6 +1277,9 @@ bool S_CheckSoundPlaying(const PointThinker *mo, int sound_id)
         if(I_SoundIsPlaying(channels[cnum].handle))
             return true;
     }
+    for(const virtualvoice_t &voice : virtualvoices)
+        if(voice.origin == mo && voice.aliasinfo && voice.aliasinfo->dehackednum == sound_id)
+            return true;
     return false;
 }
 
@@ -1056,6 +1302,11 @@ void S_StopSounds(bool killall)
         for(cnum = 0; cnum < numChannels; ++cnum)
             if(channels[cnum].sfxinfo && (killall || channels[cnum].origin))
                 S_StopChannel(cnum);
+
+    if(killall)
+        virtualvoices.makeEmpty();
+    else if(virtualvoices.getLength())
+        S_removeVirtualVoices([](const virtualvoice_t &v) { return v.origin != nullptr; });
 }
 
 //
@@ -1072,6 +1323,71 @@ void S_StopLoopedSounds()
         for(cnum = 0; cnum < numChannels; ++cnum)
             if(channels[cnum].sfxinfo && channels[cnum].looping)
                 S_StopChannel(cnum);
+
+    // all virtual voices are looping
+    virtualvoices.makeEmpty();
+}
+
+//
+// S_precacheSound
+//
+// Queues a sound for decoding, along with whatever sounds it may play
+// instead of itself.
+//
+static void S_precacheSound(sfxinfo_t *sfx, int depth)
+{
+    // don't get lost in circular definitions
+    if(!sfx || depth > 8)
+        return;
+
+    if(sfx->alias)
+        S_precacheSound(sfx->alias, depth + 1);
+    else if(sfx->randomsounds)
+    {
+        for(int i = 0; i < sfx->numrandomsounds; i++)
+            S_precacheSound(sfx->randomsounds[i], depth + 1);
+    }
+    else if(sfx->link)
+        S_precacheSound(sfx->link, depth + 1);
+    else
+        I_CacheSound(sfx);
+}
+
+//
+// S_PrecacheLevelSounds
+//
+// Queues the sounds of every kind of thing on the map for background
+// decoding, so they don't have to be decoded the first time they're heard.
+// Called at level setup.
+//
+void S_PrecacheLevelSounds()
+{
+    // with s_precache on, every sound was queued at startup
+    if(!snd_card || nosfxparm || s_precache)
+        return;
+
+    byte *hitlist = ecalloc(byte *, NUMMOBJTYPES, 1);
+
+    for(Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        const Mobj *mo = thinker_cast<const Mobj *>(th);
+        if(!mo || hitlist[mo->type])
+            continue;
+        hitlist[mo->type] = 1;
+
+        const mobjinfo_t *info = mo->info;
+
+        const int sounds[] = {
+            info->seesound,    info->attacksound,   info->painsound,       info->deathsound,
+            info->activesound, info->activatesound, info->deactivatesound, info->ripsound,
+        };
+
+        for(int sound : sounds)
+            if(sound)
+                S_precacheSound(E_SoundForDEHNum(sound), 0);
+    }
+
+    efree(hitlist);
 }
 
 void S_SetSfxVolume(int volume)
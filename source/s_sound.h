@@ -124,6 +124,7 @@ void S_ChangeMusic(musicinfo_t *music, int looping);
 void S_StopMusic(void);
 void S_StopSounds(bool killall);
 void S_StopLoopedSounds(void); // haleyjd
+void S_PrecacheLevelSounds();
 
 // Stop and resume music, during game PAUSE.
 void S_PauseSound(void);
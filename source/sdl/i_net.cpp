@@ -41,6 +41,8 @@
 #include "../d_event.h"
 #include "../d_net.h"
 #include "../m_argv.h"
+#include "../m_compare.h"
+#include "../m_qstr.h"
 
 #include "../i_net.h"
 
@@ -133,10 +135,10 @@ static uint32_t NetChecksum(byte *packetdata, int len)
    *rover++ = (b); \
    packetsize += 1
 
-#define NETWRITEBYTEIF(b, flag) \
+#define NETWRITEBYTEIF(b, cond, flag) \
     do \
     { \
-        if((b)) \
+        if(cond) \
         { \
             NETWRITEBYTE((b)); \
             ticcmdflags |= (flag); \
@@ -149,10 +151,10 @@ static uint32_t NetChecksum(byte *packetdata, int len)
     rover += 2; \
     packetsize += 2
 
-#define NETWRITESHORTIF(s, flag) \
+#define NETWRITESHORTIF(s, cond, flag) \
     do \
     { \
-        if((s)) \
+        if(cond) \
         { \
             NETWRITESHORT((s)); \
             ticcmdflags |= (flag); \
@@ -165,10 +167,10 @@ static uint32_t NetChecksum(byte *packetdata, int len)
     rover += 4; \
     packetsize += 4
 
-#define NETWRITELONGIF(dw, flag) \
+#define NETWRITELONGIF(dw, cond, flag) \
     do \
     { \
-        if((dw)) \
+        if(cond) \
         { \
             NETWRITELONG((dw)); \
             ticcmdflags |= (flag); \
@@ -191,6 +193,99 @@ enum
     TCF_SLOTINDEX   = 0x00000400,
 };
 
+//
+// Network conditions simulation
+//
+// -netloss <percent> drops that share of the outgoing packets, and
+// -netdelay <ms> [<jitter ms>] holds them back for the delay plus a random
+// part of the jitter (which may reorder them), so the netcode can be tried
+// against a bad link with all the players on one machine.
+//
+static constexpr int NETSIMQUEUE      = 256;
+static constexpr int NETSIMPACKETSIZE = int((sizeof(doomdata_t) + 31) & ~31);
+
+struct netsimpacket_t
+{
+    byte      data[NETSIMPACKETSIZE];
+    int       len;
+    IPaddress address;
+    Uint32    due;
+};
+
+static int            netsimloss, netsimdelay, netsimjitter;
+static netsimpacket_t netsimqueue[NETSIMQUEUE];
+static int            netsimcount;
+static Uint32         netsimrandom = 0x2545f491;
+
+//
+// NetSimRandom
+//
+// Private generator, so that simulating doesn't touch the game's RNG.
+//
+static Uint32 NetSimRandom()
+{
+    netsimrandom ^= netsimrandom << 13;
+    netsimrandom ^= netsimrandom >> 17;
+    netsimrandom ^= netsimrandom << 5;
+    return netsimrandom;
+}
+
+//
+// NetSimFlush
+//
+// Sends the held back packets which are due
+//
+static void NetSimFlush()
+{
+    const Uint32 now = SDL_GetTicks();
+
+    for(int i = 0; i < netsimcount;)
+    {
+        netsimpacket_t &held = netsimqueue[i];
+        if(int(now - held.due) < 0)
+        {
+            ++i;
+            continue;
+        }
+
+        UDPpacket out = *packet;
+        out.data      = held.data;
+        out.len       = held.len;
+        out.address   = held.address;
+        SDLNet_UDP_Send(udpsocket, -1, &out);
+
+        held = netsimqueue[--netsimcount];
+    }
+}
+
+//
+// NetTransmit
+//
+// Sends the packet, through the simulated link if one is set up
+//
+static bool NetTransmit()
+{
+    if(!netsimloss && !netsimdelay && !netsimjitter)
+        return SDLNet_UDP_Send(udpsocket, -1, packet) != 0;
+
+    NetSimFlush();
+
+    if(int(NetSimRandom() % 100) < netsimloss)
+        return true;
+
+    if(netsimcount == NETSIMQUEUE || packet->len > NETSIMPACKETSIZE)
+        return true; // link saturated
+
+    netsimpacket_t &held = netsimqueue[netsimcount++];
+    memcpy(held.data, packet->data, packet->len);
+    held.len     = packet->len;
+    held.address = packet->address;
+    held.due     = SDL_GetTicks() + netsimdelay + (netsimjitter ? NetSimRandom() % (netsimjitter + 1) : 0);
+
+    NetSimFlush();
+    return true;
+}
+
 // DEBUG
 
 void writesendpacket(void *data, int len)
@@ -232,31 +327,44 @@ bool PacketSend(void)
     NETWRITEBYTE(netbuffer->retransmitfrom);
     NETWRITEBYTE(netbuffer->starttic);
     NETWRITEBYTE(netbuffer->numtics);
+    NETWRITEBYTE(netbuffer->sequence);
+    NETWRITESHORT(netbuffer->sendtime);
+    NETWRITESHORT(netbuffer->echotime);
+    NETWRITESHORT(netbuffer->echodelay);
 
     if(!(netbuffer->checksum & NCMD_SETUP))
     {
+        // Each ticcmd is sent as the fields differing from the one before it
+        // in the packet, so the backup tics repeated in every packet cost
+        // little while the player holds the same input.
+        static const ticcmd_t zerocmd = {};
+        const ticcmd_t       *prev    = &zerocmd;
+
         for(c = 0; c < netbuffer->numtics; ++c)
         {
-            byte  *ticstart    = rover, *ticend;
-            Sint16 ticcmdflags = 0;
+            const ticcmd_t &cmd      = netbuffer->d.cmds[c];
+            byte           *ticstart = rover, *ticend;
+            Sint16          ticcmdflags = 0;
 
             // reserve 2 bytes for the flags
             rover += 2;
 
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].forwardmove, TCF_FORWARDMOVE);
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].sidemove, TCF_SIDEMOVE);
-            NETWRITESHORTIF(netbuffer->d.cmds[c].angleturn, TCF_ANGLETURN);
+            NETWRITEBYTEIF(cmd.forwardmove, cmd.forwardmove != prev->forwardmove, TCF_FORWARDMOVE);
+            NETWRITEBYTEIF(cmd.sidemove, cmd.sidemove != prev->sidemove, TCF_SIDEMOVE);
+            NETWRITESHORTIF(cmd.angleturn, cmd.angleturn != prev->angleturn, TCF_ANGLETURN);
 
-            NETWRITESHORT(netbuffer->d.cmds[c].consistency);
+            NETWRITESHORT(cmd.consistency);
 
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].chatchar, TCF_CHATCHAR);
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].buttons, TCF_BUTTONS);
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].actions, TCF_ACTIONS);
-            NETWRITESHORTIF(netbuffer->d.cmds[c].look, TCF_LOOK);
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].fly, TCF_FLY);
-            NETWRITESHORTIF(netbuffer->d.cmds[c].itemID, TCF_ITEMID);
-            NETWRITESHORTIF(netbuffer->d.cmds[c].weaponID, TCF_WEAPONID);
-            NETWRITEBYTEIF(netbuffer->d.cmds[c].chatchar, TCF_CHATCHAR);
+            NETWRITEBYTEIF(cmd.chatchar, cmd.chatchar != prev->chatchar, TCF_CHATCHAR);
+            NETWRITEBYTEIF(cmd.buttons, cmd.buttons != prev->buttons, TCF_BUTTONS);
+            NETWRITEBYTEIF(cmd.actions, cmd.actions != prev->actions, TCF_ACTIONS);
+            NETWRITESHORTIF(cmd.look, cmd.look != prev->look, TCF_LOOK);
+            NETWRITEBYTEIF(cmd.fly, cmd.fly != prev->fly, TCF_FLY);
+            NETWRITESHORTIF(cmd.itemID, cmd.itemID != prev->itemID, TCF_ITEMID);
+            NETWRITESHORTIF(cmd.weaponID, cmd.weaponID != prev->weaponID, TCF_WEAPONID);
+            NETWRITEBYTEIF(cmd.slotIndex, cmd.slotIndex != prev->slotIndex, TCF_SLOTINDEX);
+
+            prev = &cmd;
 
             // go back to ticstart and write in the flags
             ticend = rover;
@@ -285,7 +393,7 @@ bool PacketSend(void)
     // DEBUG
     writesendpacket(packet->data, packet->len);
 
-    if(!SDLNet_UDP_Send(udpsocket, -1, packet))
+    if(!NetTransmit())
     {
         I_Error("Error sending packet: %s\n", SDLNet_GetError());
         return false;
@@ -303,6 +411,9 @@ bool PacketGet(void)
     int      i, c, packets_read;
     byte    *rover;
 
+    if(netsimcount)
+        NetSimFlush();
+
     packets_read = SDLNet_UDP_Recv(udpsocket, packet);
 
     if(packets_read < 0)
@@ -348,9 +459,18 @@ bool PacketGet(void)
     netbuffer->retransmitfrom = *rover++;
     netbuffer->starttic       = *rover++;
     netbuffer->numtics        = *rover++;
+    netbuffer->sequence       = *rover++;
+    netbuffer->sendtime       = NetToHost16(rover);
+    netbuffer->echotime       = NetToHost16(rover + 2);
+    netbuffer->echodelay      = NetToHost16(rover + 4);
+
+    rover += 6;
 
     if(!(netbuffer->checksum & NCMD_SETUP))
     {
+        if(netbuffer->numtics > BACKUPTICS)
+            return false;
+
         for(c = 0; c < netbuffer->numtics; ++c)
         {
             Sint16 ticcmdflags;
@@ -358,7 +478,11 @@ bool PacketGet(void)
             ticcmdflags  = NetToHost16(rover);
             rover       += 2;
 
-            memset(&(netbuffer->d.cmds[c]), 0, sizeof(ticcmd_t));
+            // fields not sent are the same as in the previous ticcmd
+            if(c)
+                netbuffer->d.cmds[c] = netbuffer->d.cmds[c - 1];
+            else
+                memset(&(netbuffer->d.cmds[c]), 0, sizeof(ticcmd_t));
 
             if(ticcmdflags & TCF_FORWARDMOVE)
                 netbuffer->d.cmds[c].forwardmove = *rover++;
@@ -455,10 +579,23 @@ void I_InitNetwork(void)
     else
         doomcom->ticdup = 1;
 
-    if(M_CheckParm("-extratic"))
+    // -extratic [n]: backup tics to repeat in every packet
+    doomcom->extratics = DEFAULTEXTRATICS;
+    if((i = M_CheckParm("-extratic")))
+    {
         doomcom->extratics = 1;
-    else
-        doomcom->extratics = 0;
+        if(i < myargc - 1 && myargv[i + 1][0] != '-')
+            doomcom->extratics = eclamp(atoi(myargv[i + 1]), 0, BACKUPTICS / 2 - 1);
+    }
+
+    if((p = M_CheckParm("-netloss")) && p < myargc - 1)
+        netsimloss = eclamp(atoi(myargv[p + 1]), 0, 100);
+    if((p = M_CheckParm("-netdelay")) && p < myargc - 1)
+    {
+        netsimdelay = emax(atoi(myargv[p + 1]), 0);
+        if(p < myargc - 2 && myargv[p + 2][0] != '-')
+            netsimjitter = emax(atoi(myargv[p + 2]), 0);
+    }
 
     p = M_CheckParm("-port");
     if(p && p < myargc - 1)
@@ -500,15 +637,37 @@ void I_InitNetwork(void)
 
     I_AtExit(I_QuitNetwork);
 
+    // hosts may be given as host:port, so that several players can run on
+    // the same machine with different -port values
     i++;
     while(++i < myargc && myargv[i][0] != '-')
     {
-        if(SDLNet_ResolveHost(&sendaddress[doomcom->numnodes], myargv[i], DOOMPORT))
+        if(doomcom->numnodes == MAXNETNODES)
+            I_Error("I_InitNetwork: too many nodes given to -net\n");
+
+        qstring     host(myargv[i]);
+        Uint16      port  = DOOMPORT;
+        const char *colon = strrchr(myargv[i], ':');
+        if(colon)
+        {
+            host.truncate(colon - myargv[i]);
+            port = Uint16(atoi(colon + 1));
+        }
+
+        if(SDLNet_ResolveHost(&sendaddress[doomcom->numnodes], host.constPtr(), port))
             I_Error("Unable to resolve %s\n", myargv[i]);
 
         doomcom->numnodes++;
     }
 
+    if(netsimloss || netsimdelay || netsimjitter)
+    {
+        usermsg("Simulating %d%% packet loss, %d+%d ms delay\n", netsimloss, netsimdelay, netsimjitter);
+        netsimrandom ^= SDL_GetTicks();
+        if(!netsimrandom)
+            netsimrandom = 1;
+    }
+
     doomcom->id         = DOOMCOM_ID;
     doomcom->numplayers = doomcom->numnodes;
 
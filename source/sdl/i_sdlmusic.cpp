@@ -24,7 +24,10 @@
 // haleyjd 11/22/08: I don't understand why this is needed here...
 #define USE_RWOPS
 
+#include <atomic>
+#include <chrono>
 #include <optional>
+#include <thread>
 
 #include "SDL.h"
 #include "SDL_mixer.h"
@@ -233,6 +236,138 @@ static void I_effectADLMIDI(void *udata, Uint8 *stream, int len)
 
 #endif
 
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+//
+// Synthesized music is rendered ahead of the audio callback on its own thread,
+// into a single-producer single-consumer ring buffer. The callback only copies
+// out of the ring, so a slow synth (e.g. several emulated OPL3 chips) only
+// causes a dropout if it falls behind by the whole buffer.
+//
+
+int snd_musicbuffer = 100; // milliseconds of music rendered ahead
+
+std::atomic<int> mus_underruns; // callbacks the ring couldn't fill
+
+static constexpr int MUSICCHUNKFRAMES = 512; // frames rendered per synth call
+
+using musicsynth_t = void (*)(void *, Uint8 *, int);
+
+static musicsynth_t        musicsynth; // I_effectSPC or I_effectADLMIDI
+static std::thread         musicthread;
+static std::atomic<bool>   musicthreadquit;
+static std::atomic<bool>   musicprimed; // ring was filled once, so count underruns
+static Uint8              *musicring;
+static size_t              musicringmask;
+static std::atomic<size_t> musicringread, musicringwrite; // running byte counts
+
+//
+// Worker rendering chunks of music into the ring whenever there's room.
+//
+static void I_musicThreadFunc(size_t chunkbytes)
+{
+    Uint8 *chunk = static_cast<Uint8 *>(Z_SysMalloc(chunkbytes));
+
+    while(!musicthreadquit.load(std::memory_order_relaxed))
+    {
+        const size_t write = musicringwrite.load(std::memory_order_relaxed);
+        const size_t used  = write - musicringread.load(std::memory_order_acquire);
+
+        if(musicringmask + 1 - used < chunkbytes || Mix_PausedMusic())
+        {
+            musicprimed.store(true, std::memory_order_relaxed);
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            continue;
+        }
+
+        // the synths mix into the buffer they're given
+        memset(chunk, 0, chunkbytes);
+        musicsynth(nullptr, chunk, int(chunkbytes));
+
+        const size_t start = write & musicringmask;
+        const size_t first = emin(chunkbytes, musicringmask + 1 - start);
+        memcpy(musicring + start, chunk, first);
+        memcpy(musicring, chunk + first, chunkbytes - first);
+
+        musicringwrite.store(write + chunkbytes, std::memory_order_release);
+    }
+
+    Z_SysFree(chunk);
+}
+
+//
+// SDL_mixer music hook; copies rendered music out of the ring.
+//
+static void I_musicStreamCallback(void *udata, Uint8 *stream, int len)
+{
+    const size_t read  = musicringread.load(std::memory_order_relaxed);
+    const size_t avail = musicringwrite.load(std::memory_order_acquire) - read;
+    const size_t count = emin(size_t(len), avail);
+
+    const size_t start = read & musicringmask;
+    const size_t first = emin(count, musicringmask + 1 - start);
+    memcpy(stream, musicring + start, first);
+    memcpy(stream + first, musicring, count - first);
+
+    musicringread.store(read + count, std::memory_order_release);
+
+    // the rest of the stream stays silent
+    if(count < size_t(len) && musicprimed.load(std::memory_order_relaxed))
+        mus_underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+//
+// Starts rendering music with the given synth and hooks the ring up to
+// SDL_mixer.
+//
+static void I_stopMusicStream();
+
+static void I_startMusicStream(musicsynth_t synth)
+{
+    I_stopMusicStream();
+
+    const size_t framebytes = (float_samples ? sizeof(float) : sizeof(Sint16)) * audio_spec.channels;
+    const size_t chunkbytes = framebytes * MUSICCHUNKFRAMES;
+
+    // the ring holds at least a few chunks, and its size is a power of two
+    const size_t wanted   = emax(size_t(audio_spec.freq) * snd_musicbuffer / 1000 * framebytes, chunkbytes * 4);
+    size_t       ringsize = chunkbytes;
+    while(ringsize < wanted)
+        ringsize <<= 1;
+
+    musicring     = static_cast<Uint8 *>(Z_SysMalloc(ringsize));
+    musicringmask = ringsize - 1;
+    musicringread.store(0);
+    musicringwrite.store(0);
+    musicprimed.store(false);
+    musicthreadquit.store(false);
+    musicsynth  = synth;
+    musicthread = std::thread(I_musicThreadFunc, chunkbytes);
+
+    Mix_HookMusic(I_musicStreamCallback, nullptr);
+}
+
+//
+// Unhooks the music stream and waits for its worker, so the synth it was
+// using can be freed.
+//
+static void I_stopMusicStream()
+{
+    Mix_HookMusic(nullptr, nullptr);
+
+    if(musicthread.joinable())
+    {
+        musicthreadquit.store(true);
+        musicthread.join();
+    }
+
+    if(musicring)
+    {
+        Z_SysFree(musicring);
+        musicring = nullptr;
+    }
+}
+#endif
+
 //
 // MUSIC API.
 //
@@ -358,14 +493,14 @@ static void I_SDLPlaySong(int handle, int looping)
 #ifdef HAVE_SPCLIB
     // if a SPC is set up, play it.
     if(snes_spc)
-        Mix_HookMusic(float_samples ? I_effectSPC<float> : I_effectSPC<Sint16>, nullptr);
+        I_startMusicStream(float_samples ? I_effectSPC<float> : I_effectSPC<Sint16>);
     else
 #endif
 #ifdef HAVE_ADLMIDILIB
         if(adlmidi_player)
     {
-        Mix_HookMusic(float_samples ? I_effectADLMIDI<float> : I_effectADLMIDI<Sint16>, nullptr);
         adl_setLoopEnabled(adlmidi_player, looping);
+        I_startMusicStream(float_samples ? I_effectADLMIDI<float> : I_effectADLMIDI<Sint16>);
     }
     else
 #endif
@@ -476,14 +611,8 @@ static void I_SDLStopSong(int handle)
     if(CHECK_MUSIC(handle))
         Mix_HaltMusic();
 
-#ifdef HAVE_SPCLIB
-    if(snes_spc)
-        Mix_HookMusic(nullptr, nullptr);
-#endif
-
-#ifdef HAVE_ADLMIDILIB
-    if(adlmidi_player)
-        Mix_HookMusic(nullptr, nullptr);
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+    I_stopMusicStream();
 #endif
 }
 
@@ -503,7 +632,7 @@ static void I_SDLUnRegisterSong(int handle)
 #ifdef HAVE_ADLMIDILIB
     if(adlmidi_player)
     {
-        Mix_HookMusic(nullptr, nullptr);
+        I_stopMusicStream();
         adl_close(adlmidi_player);
         adlmidi_player = nullptr;
     }
@@ -531,7 +660,7 @@ static void I_SDLUnRegisterSong(int handle)
     if(snes_spc)
     {
         // be certain the callback is unregistered first
-        Mix_HookMusic(nullptr, nullptr);
+        I_stopMusicStream();
 
         // free the spc and filter objects
         spc_delete(snes_spc);
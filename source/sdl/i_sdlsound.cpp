@@ -790,6 +790,7 @@ static void I_SDLSubmitSound()
 static void I_SDLShutdownSound()
 {
     Mix_CloseAudio();
+    S_ShutdownSoundDecoding();
 }
 
 //
@@ -799,8 +800,8 @@ static void I_SDLShutdownSound()
 //
 static void I_SDLCacheSound(sfxinfo_t *sound)
 {
-    // 12/23/13: invoke high level lump cacher
-    S_CacheDigitalSoundLump(sound);
+    // decode it in the background, so it's ready by the time it's played
+    S_QueueSoundDecode(sound);
 }
 
 static void I_SDLDummyCallback(void *, Uint8 *, int) {}
@@ -36,6 +36,7 @@
 #include "../m_argv.h"
 #include "../m_misc.h"
 #include "../m_vector.h"
+#include "../r_context.h"
 #include "../v_misc.h"
 #include "../v_video.h"
 #include "../version.h"
@@ -74,6 +75,65 @@ extern bool noblit;
 static SDL_Color basepal[256], colors[256];
 static bool      setpalette = false;
 
+// Palette expanded to the texture's pixel format, used for converting the
+// frame on the render threads when the texture is 32 bits per pixel.
+static Uint32 truecolors[256];
+static bool   directconvert;
+
+//
+// Frame conversion job shared by the render threads
+//
+struct palconvert_t
+{
+    const byte *src;
+    int         srcpitch;
+    byte       *dest;
+    int         destpitch;
+    int         width; // surface width (screen height, as the buffer is transposed)
+    int         height;
+};
+
+//
+// Expands the paletted frame to true colour, for the surface rows (screen
+// columns) belonging to one render context
+//
+static void I_convertFrameRows(int index, int count, void *data)
+{
+    const palconvert_t &job   = *static_cast<const palconvert_t *>(data);
+    const int           start = job.height * index / count;
+    const int           stop  = job.height * (index + 1) / count;
+    const int           width = job.width;
+
+    for(int y = start; y < stop; y++)
+    {
+        const byte *src  = job.src + y * job.srcpitch;
+        Uint32     *dest = reinterpret_cast<Uint32 *>(job.dest + y * job.destpitch);
+        int         x    = 0;
+
+        for(; x + 4 <= width; x += 4)
+        {
+            dest[x]     = truecolors[src[x]];
+            dest[x + 1] = truecolors[src[x + 1]];
+            dest[x + 2] = truecolors[src[x + 2]];
+            dest[x + 3] = truecolors[src[x + 3]];
+        }
+        for(; x < width; x++)
+            dest[x] = truecolors[src[x]];
+    }
+}
+
+//
+// Rebuilds the true colour palette from the current colours
+//
+static void I_updateTrueColors()
+{
+    if(!rgba_surface)
+        return;
+
+    for(int i = 0; i < 256; i++)
+        truecolors[i] = SDL_MapRGB(rgba_surface->format, colors[i].r, colors[i].g, colors[i].b);
+}
+
 extern char *i_resolution;
 extern char *i_videomode;
 
@@ -100,6 +160,7 @@ void SDLVideoDriver::FinishUpdate()
     {
         if(primary_surface)
             SDL_SetPaletteColors(primary_surface->format->palette, colors, 0, 256);
+        I_updateTrueColors();
 
         setpalette = false;
     }
@@ -107,9 +168,28 @@ void SDLVideoDriver::FinishUpdate()
     // haleyjd 11/12/09: blit *after* palette set improves behavior.
     if(primary_surface)
     {
-        // Don't bother checking for errors. It should just cancel itself in that case.
-        SDL_BlitSurface(primary_surface, nullptr, rgba_surface, nullptr);
-        SDL_UpdateTexture(sdltexture, nullptr, rgba_surface->pixels, rgba_surface->pitch);
+        void *pixels;
+        int   pitch;
+
+        // Expand straight into the streaming texture, split across the render
+        // threads, unless the window format needs SDL's generic conversion.
+        if(directconvert && !SDL_LockTexture(sdltexture, nullptr, &pixels, &pitch))
+        {
+            palconvert_t job = { static_cast<const byte *>(primary_surface->pixels),
+                                 primary_surface->pitch,
+                                 static_cast<byte *>(pixels),
+                                 pitch,
+                                 primary_surface->w,
+                                 primary_surface->h };
+            R_RunContextTask(I_convertFrameRows, &job);
+            SDL_UnlockTexture(sdltexture);
+        }
+        else
+        {
+            // Don't bother checking for errors. It should just cancel itself in that case.
+            SDL_BlitSurface(primary_surface, nullptr, rgba_surface, nullptr);
+            SDL_UpdateTexture(sdltexture, nullptr, rgba_surface->pixels, rgba_surface->pitch);
+        }
 #if EE_CURRENT_PLATFORM == EE_PLATFORM_MACOSX
 #ifdef __arm64__
         // Must clear the renderer on ARM Apple systems, otherwise we get random garbled view on the
@@ -156,6 +236,7 @@ static void I_SDLSetPaletteDirect(byte *palette)
 
     if(primary_surface)
         SDL_SetPaletteColors(primary_surface->format->palette, colors, 0, 256);
+    I_updateTrueColors();
 }
 
 //
@@ -206,6 +287,7 @@ void SDLVideoDriver::UnsetPrimaryBuffer()
         SDL_FreeSurface(rgba_surface);
         rgba_surface = nullptr;
     }
+    directconvert = false;
     if(primary_surface)
     {
         SDL_FreeSurface(primary_surface);
@@ -248,6 +330,10 @@ void SDLVideoDriver::SetPrimaryBuffer()
             I_Error("SDLVideoDriver::SetPrimaryBuffer: failed to create rendering texture: %s\n", SDL_GetError());
         }
 
+        directconvert = SDL_BYTESPERPIXEL(pixelformat) == 4 && !SDL_ISPIXELFORMAT_INDEXED(pixelformat) &&
+                        !SDL_ISPIXELFORMAT_FOURCC(pixelformat);
+        I_updateTrueColors();
+
         video.screens[0] = static_cast<byte *>(primary_surface->pixels);
         video.pitch      = primary_surface->pitch;
     }
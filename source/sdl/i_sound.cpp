@@ -21,6 +21,8 @@
 // Authors: James Haley, Max Waine
 //
 
+#include <atomic>
+
 #include "../z_zone.h"
 
 #include "../c_runcmd.h"
@@ -422,6 +424,12 @@ VARIABLE_INT(adlmidi_emulator, nullptr,  0, ADLMIDI_EMU_end - 1, adlemustr);
 static_assert(earrlen(adlemustr) == ADLMIDI_EMU_end, "Length of adlemustr and number of ADLMIDI emulators not equal.");
 #endif
 
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+extern int snd_musicbuffer;
+
+VARIABLE_INT(snd_musicbuffer,  nullptr, 20, 2000,                  nullptr);
+#endif
+
 // Equalizer variables
 
 VARIABLE_FLOAT(s_lowfreq,  nullptr, 0.0, UL);
@@ -466,6 +474,21 @@ CONSOLE_VARIABLE(snd_numchips,    adlmidi_numchips, 0) {}
 CONSOLE_VARIABLE(snd_bank,        adlmidi_bank, 0)     {}
 CONSOLE_VARIABLE(snd_oplemulator, adlmidi_emulator, 0) {}
 #endif
+
+#if defined(HAVE_SPCLIB) || defined(HAVE_ADLMIDILIB)
+// takes effect the next time a song starts
+CONSOLE_VARIABLE(snd_musicbuffer, snd_musicbuffer, 0) {}
+
+extern std::atomic<int> mus_underruns;
+
+CONSOLE_COMMAND(snd_musicunderruns, 0)
+{
+    C_Printf("%d music buffer underruns (snd_musicbuffer %d ms)\n", mus_underruns.load(), snd_musicbuffer);
+
+    if(Console.argc >= 1 && !strcasecmp(Console.argv[0]->constPtr(), "reset"))
+        mus_underruns.store(0);
+}
+#endif
 #endif
 
 //
@@ -61,6 +61,8 @@ enum
     SFXF_ADDDEH    = 0x00000020, // sfxinfo was born via additive dehacked lump
 };
 
+struct sounddecode_t;
+
 struct sfxinfo_t
 {
     // Sfx singularity (only one at a time)
@@ -106,9 +108,10 @@ struct sfxinfo_t
     int         numrandomsounds;
 
     // haleyjd 04/23/08: additional caching data
-    void        *data;   // sound data
-    int          length; // lump length
-    unsigned int alen;   // length of converted sound pointed to by data
+    void          *data;   // sound data
+    int            length; // lump length
+    unsigned int   alen;   // length of converted sound pointed to by data
+    sounddecode_t *decode; // pending background decode, if any
 
     // this is checked every second to see if sound
     // can be thrown out (if 0, then decrement, if -1,
@@ -42,6 +42,7 @@
 #include "r_context.h"
 #include "r_main.h" // haleyjd
 #include "r_patch.h"
+#include "r_ripple.h"
 #include "r_state.h"
 #include "v_alloc.h"
 #include "v_block.h"
@@ -583,8 +584,6 @@ void V_DrawBackground(const char *patchname, VBuffer *back_dest)
     back_dest->TileBlock64(back_dest, src);
 }
 
-byte *R_DistortedFlat(ZoneHeap &heap, int, bool);
-
 //
 // V_DrawDistortedBackground
 //
@@ -595,7 +594,7 @@ void V_DrawDistortedBackground(const char *patchname, VBuffer *back_dest)
 {
     const int patchNum = R_FindFlat(patchname);
     R_CacheTexture(patchNum);
-    const byte *src = R_DistortedFlat(*r_globalcontext.heap, patchNum, true);
+    const byte *src = R_DistortedFlat(*r_globalcontext.heap, r_globalcontext.planecontext, patchNum, true);
 
     back_dest->TileBlock64(back_dest, src);
 }
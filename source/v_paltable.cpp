@@ -0,0 +1,177 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Building and caching of palette-derived lookup tables.
+//
+//  The translucency maps and the RGB32k table are brute-force nearest color
+//  searches over the whole palette. Their rows don't depend on each other, so
+//  they're built on all cores, and the result is saved under
+//  <userpath>/cache so the next launch with the same palette just reads it.
+//  The cache file holds the whole palette and the builder parameter, so a
+//  hash collision in the file name can't hand back the wrong table.
+//
+// Authors: Ioan Chera
+//
+
+#if __cplusplus >= 201703L || _MSC_VER >= 1914
+#include "hal/i_platform.h"
+#include <filesystem>
+namespace fs = std::filesystem;
+#else
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#endif
+
+#include <atomic>
+#include <thread>
+
+#include "z_zone.h"
+
+#include "hal/i_directory.h"
+#include "doomstat.h"
+#include "m_argv.h"
+#include "m_binary.h"
+#include "m_compare.h"
+#include "m_qstr.h"
+#include "m_utils.h"
+#include "v_paltable.h"
+
+static constexpr char   PALTABLE_MAGIC[8] = { 'E', 'E', 'P', 'A', 'L', 'T', 'B', '1' };
+static constexpr size_t PALTABLE_HEADER   = sizeof(PALTABLE_MAGIC) + 4 + 4 + 768;
+
+//
+// Calls buildrow for every row, with one worker per core pulling the next
+// free row. Rows must not depend on each other.
+//
+void V_PalTableParallel(int numrows, const std::function<void(int)> &buildrow)
+{
+    const int numworkers = emin(static_cast<int>(emax(std::thread::hardware_concurrency(), 1u)), numrows);
+
+    if(numworkers <= 1)
+    {
+        for(int row = 0; row < numrows; row++)
+            buildrow(row);
+        return;
+    }
+
+    std::atomic<int> next(0);
+    auto             work = [&]() {
+        int row;
+        while((row = next.fetch_add(1)) < numrows)
+            buildrow(row);
+    };
+
+    // the calling thread is one of the workers
+    std::thread *workers = new std::thread[numworkers - 1];
+    for(int i = 0; i < numworkers - 1; i++)
+        workers[i] = std::thread(work);
+    work();
+    for(int i = 0; i < numworkers - 1; i++)
+        workers[i].join();
+    delete[] workers;
+}
+
+//
+// Gets the cache file path for a table, or false if there's no cache
+//
+static bool V_palTablePath(const char *kind, const byte *palette, int param, qstring &path)
+{
+    static int nocache = -1;
+    if(nocache < 0)
+        nocache = M_CheckParm("-nopalcache") != 0;
+    if(nocache || !userpath)
+        return false;
+
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for(int i = 0; i < 768; i++)
+        hash = (hash ^ palette[i]) * 16777619u;
+
+    path = userpath;
+    path.pathConcatenate("cache");
+    path.pathConcatenate(qstring::Format("%s_%08x_%d.lut", kind, hash, param).constPtr());
+    return true;
+}
+
+//
+// Reads a table from the cache. Returns false if it's missing or was built
+// from anything else.
+//
+bool V_PalTableLoad(const char *kind, const byte *palette, int param, byte *dest, size_t size)
+{
+    qstring path;
+    if(!V_palTablePath(kind, palette, param, path))
+        return false;
+
+    byte     *buffer = nullptr;
+    const int length = M_ReadFile(path.constPtr(), &buffer);
+    if(length < 0)
+        return false;
+
+    bool  valid = false;
+    byte *p     = buffer;
+    if(static_cast<size_t>(length) == PALTABLE_HEADER + size && !memcmp(p, PALTABLE_MAGIC, sizeof(PALTABLE_MAGIC)))
+    {
+        p += sizeof(PALTABLE_MAGIC);
+        const int32_t  fileparam = GetBinaryDWord(p);
+        const uint32_t filesize  = GetBinaryUDWord(p);
+        valid = fileparam == param && filesize == size && !memcmp(p, palette, 768);
+        if(valid)
+            memcpy(dest, p + 768, size);
+    }
+
+    efree(buffer);
+    return valid;
+}
+
+//
+// Writes a freshly built table to the cache. Failure is only a lost speedup,
+// so it's silent.
+//
+void V_PalTableSave(const char *kind, const byte *palette, int param, const byte *src, size_t size)
+{
+    qstring path;
+    if(!V_palTablePath(kind, palette, param, path))
+        return;
+
+    qstring         dir(userpath);
+    std::error_code ec;
+    dir.pathConcatenate("cache");
+    if(!fs::is_directory(dir.constPtr(), ec) && !I_CreateDirectory(dir))
+        return;
+
+    byte *buffer = emalloc(byte *, PALTABLE_HEADER + size);
+    byte *p      = buffer;
+    memcpy(p, PALTABLE_MAGIC, sizeof(PALTABLE_MAGIC));
+    p += sizeof(PALTABLE_MAGIC);
+    for(int shift = 0; shift < 32; shift += 8)
+        *p++ = static_cast<byte>(static_cast<uint32_t>(param) >> shift);
+    for(int shift = 0; shift < 32; shift += 8)
+        *p++ = static_cast<byte>(static_cast<uint32_t>(size) >> shift);
+    memcpy(p, palette, 768);
+    memcpy(p + 768, src, size);
+
+    M_WriteFile(path.constPtr(), buffer, PALTABLE_HEADER + size);
+    efree(buffer);
+}
+
+// EOF
@@ -0,0 +1,44 @@
+//
+// The Eternity Engine
+// Copyright (C) 2025 James Haley, Ioan Chera, et al.
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see http://www.gnu.org/licenses/
+//
+// Additional terms and conditions compatible with the GPLv3 apply. See the
+// file COPYING-EE for details.
+//
+//------------------------------------------------------------------------------
+//
+// Purpose: Building and caching of palette-derived lookup tables.
+// Authors: Ioan Chera
+//
+
+#ifndef V_PALTABLE_H__
+#define V_PALTABLE_H__
+
+#include <functional>
+
+#include "doomtype.h"
+
+// Calls buildrow for every row in [0, numrows), spread over the CPU cores
+void V_PalTableParallel(int numrows, const std::function<void(int)> &buildrow);
+
+// Cache of built tables in the user directory, keyed by the palette and one
+// parameter of the builder
+bool V_PalTableLoad(const char *kind, const byte *palette, int param, byte *dest, size_t size);
+void V_PalTableSave(const char *kind, const byte *palette, int param, const byte *src, size_t size);
+
+#endif
+
+// EOF
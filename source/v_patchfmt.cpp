@@ -257,6 +257,137 @@ patch_t *PatchLoader::CacheName(WadDirectory &dir, const char *name, int tag, in
     return PatchLoader::CacheNum(dir, dir.checkNumForName(name, ns), tag);
 }
 
+//
+// PatchLoader::CacheMaskedNum
+//
+// Static method to get the baked masked form of a patch lump, building it
+// the first time it is asked for. Main thread only: it allocates from the
+// zone. The result is kept until the level ends and holds its own copy of the
+// pixels, so it stays valid even if the source patch is purged. lumpnum must
+// be a valid lump.
+//
+const maskedpatch_t *PatchLoader::CacheMaskedNum(WadDirectory &dir, int lumpnum)
+{
+    void *&slot = dir.getLumpInfo()[lumpnum]->cache[lumpinfo_t::fmt_maskedpatch];
+    if(slot)
+        return static_cast<const maskedpatch_t *>(slot);
+
+    patch_t *patch  = CacheNum(dir, lumpnum, PU_CACHE);
+    int      oldtag = Z_CheckTag(patch);
+    if(oldtag >= PU_PURGELEVEL)
+        Z_ChangeTag(patch, PU_STATIC);
+
+    const byte *base  = reinterpret_cast<const byte *>(patch);
+    const int   width = patch->width;
+
+    // First pass: count the runs and the pixel bytes they need.
+    size_t numruns = 0, numpixels = 0;
+    for(int x = 0; x < width; x++)
+    {
+        const column_t *post = reinterpret_cast<const column_t *>(base + patch->columnofs[x]);
+        int             top = 0, end = -1;
+
+        for(; post->topdelta != 0xff; post = reinterpret_cast<const column_t *>(
+                                          reinterpret_cast<const byte *>(post) + post->length + 4))
+        {
+            // DeePsea tall patches: a delta at or above the last one is relative
+            top = post->topdelta <= top ? post->topdelta + top : post->topdelta;
+            if(!post->length)
+                continue;
+            if(top != end)
+            {
+                numruns++;
+                numpixels += 2;
+            }
+            numpixels += post->length;
+            end        = top + post->length;
+        }
+    }
+
+    const size_t headsize = sizeof(maskedpatch_t) + width * sizeof(maskedpatchcol_t);
+    const size_t size     = headsize + numruns * sizeof(maskedrun_t) + numpixels;
+
+    byte *const buffer = static_cast<byte *>(Z_Malloc(size, PU_LEVEL, &slot));
+
+    maskedpatch_t    *mpatch  = reinterpret_cast<maskedpatch_t *>(buffer);
+    maskedpatchcol_t *columns = reinterpret_cast<maskedpatchcol_t *>(buffer + sizeof(maskedpatch_t));
+    maskedrun_t      *run     = reinterpret_cast<maskedrun_t *>(buffer + headsize);
+    byte             *pixels  = buffer + headsize + numruns * sizeof(maskedrun_t);
+
+    mpatch->width       = patch->width;
+    mpatch->height      = patch->height;
+    mpatch->leftoffset  = patch->leftoffset;
+    mpatch->topoffset   = patch->topoffset;
+    mpatch->firstcolumn = patch->width;
+    mpatch->lastcolumn  = -1;
+    mpatch->columns     = columns;
+
+    // Second pass: fill in the runs. Pixels of touching posts are laid out
+    // back to back, and each run keeps the pad bytes that surround its posts
+    // in the lump, so the drawers read the same bytes at the run edges.
+    for(int x = 0; x < width; x++)
+    {
+        const column_t *post = reinterpret_cast<const column_t *>(base + patch->columnofs[x]);
+        int             top = 0, end = -1;
+
+        columns[x].runs    = run;
+        columns[x].numruns = 0;
+
+        for(; post->topdelta != 0xff; post = reinterpret_cast<const column_t *>(
+                                          reinterpret_cast<const byte *>(post) + post->length + 4))
+        {
+            top = post->topdelta <= top ? post->topdelta + top : post->topdelta;
+            if(!post->length)
+                continue;
+
+            const byte *src = reinterpret_cast<const byte *>(post) + 3;
+            if(top == end)
+            {
+                // Joins the run before it; overwrite that run's trailing pad.
+                pixels--;
+                run[-1].length += post->length;
+            }
+            else
+            {
+                *pixels++   = src[-1];
+                run->top    = top;
+                run->length = post->length;
+                run->source = pixels;
+                run++;
+                columns[x].numruns++;
+            }
+            memcpy(pixels, src, post->length);
+            pixels   += post->length;
+            *pixels++ = src[post->length];
+            end       = top + post->length;
+        }
+
+        if(columns[x].numruns)
+        {
+            if(mpatch->firstcolumn > x)
+                mpatch->firstcolumn = x;
+            mpatch->lastcolumn = x;
+        }
+    }
+
+    if(oldtag >= PU_PURGELEVEL)
+        Z_ChangeTag(patch, oldtag);
+
+    return mpatch;
+}
+
+//
+// PatchLoader::GetMaskedNum
+//
+// Static method to get the baked masked form of a patch lump only if it has
+// already been built by CacheMaskedNum, or nullptr. Safe to call from the
+// render threads, as nothing is built or freed while they run.
+//
+const maskedpatch_t *PatchLoader::GetMaskedNum(WadDirectory &dir, int lumpnum)
+{
+    return static_cast<const maskedpatch_t *>(dir.getLumpInfo()[lumpnum]->cache[lumpinfo_t::fmt_maskedpatch]);
+}
+
 //
 // PatchLoader::GetUsedColors
 //
@@ -29,6 +29,7 @@
 
 #include "w_wad.h"
 
+struct maskedpatch_t;
 struct patch_t;
 
 class PatchLoader : public WadLumpLoader
@@ -51,6 +52,9 @@ public:
     static patch_t *CacheName(WadDirectory &dir, const char *name, int tag, int ns = lumpinfo_t::ns_global);
     static patch_t *CacheNum(WadDirectory &dir, int lumpnum, int tag);
 
+    static const maskedpatch_t *CacheMaskedNum(WadDirectory &dir, int lumpnum);
+    static const maskedpatch_t *GetMaskedNum(WadDirectory &dir, int lumpnum);
+
     static bool VerifyAndFormat(void *data, size_t size);
     static void GetUsedColors(patch_t *patch, byte *pal);
 };
@@ -32,11 +32,13 @@
 #include "doomstat.h"
 #include "i_video.h"
 #include "m_bbox.h"
+#include "m_compare.h"
 #include "r_draw.h"
 #include "r_main.h"
 #include "r_patch.h"
 #include "v_block.h"
 #include "v_misc.h"
+#include "v_paltable.h"
 #include "v_patchfmt.h"
 #include "v_video.h"
 #include "w_wad.h" /* needed for color translation lump lookup */
@@ -782,9 +784,34 @@ struct tpalcol_t
     unsigned int r, g, b;
 };
 
+//
+// Same result as V_FindBestColor, from a transposed palette. All the
+// distortions are computed in one branchless pass so it vectorizes; the
+// lowest index with the smallest one wins, as in the upward scan.
+//
+static byte V_nearestRGBColor(const int (&pal)[3][256], int r, int g, int b)
+{
+    int distortion[256];
+    int best = INT_MAX;
+    for(int i = 0; i < 256; i++)
+    {
+        const int dr = r - pal[0][i];
+        const int dg = g - pal[1][i];
+        const int db = b - pal[2][i];
+
+        distortion[i] = dr * dr + dg * dg + db * db;
+        best          = emin(best, distortion[i]);
+    }
+
+    int color = 0;
+    while(distortion[color] != best)
+        ++color;
+    return static_cast<byte>(color);
+}
+
 void V_InitFlexTranTable(const byte *palette)
 {
-    int         i, r, g, b, x, y;
+    int         i, x, y;
     tpalcol_t  *tempRGBpal;
     const byte *palRover;
 
@@ -800,16 +827,24 @@ void V_InitFlexTranTable(const byte *palette)
         tempRGBpal[i].b = palRover[2];
     }
 
-    // build RGB table
-    for(r = 0; r < 32; ++r)
+    // build RGB table, one red and green pair per row
+    if(!V_PalTableLoad("rgb32k", palette, 0, &RGB32k[0][0][0], sizeof(RGB32k)))
     {
-        for(g = 0; g < 32; ++g)
+        int pal[3][256];
+        for(i = 0; i < 256; i++)
         {
-            for(b = 0; b < 32; ++b)
-            {
-                RGB32k[r][g][b] = V_FindBestColor(palette, MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
-            }
+            pal[0][i] = tempRGBpal[i].r;
+            pal[1][i] = tempRGBpal[i].g;
+            pal[2][i] = tempRGBpal[i].b;
         }
+
+        V_PalTableParallel(32 * 32, [&](int row) {
+            const int r = row >> 5;
+            const int g = row & 31;
+            for(int b = 0; b < 32; ++b)
+                RGB32k[r][g][b] = V_nearestRGBColor(pal, MAKECOLOR(r), MAKECOLOR(g), MAKECOLOR(b));
+        });
+        V_PalTableSave("rgb32k", palette, 0, &RGB32k[0][0][0], sizeof(RGB32k));
     }
 
     // build lookup table
@@ -114,9 +114,10 @@ struct lumpinfo_t
     // haleyjd 09/03/12: lump cache formats
     enum lumpformat
     {
-        fmt_default, // always used for the raw untranslated lump data
-        fmt_patch,   // converted to a patch
-        fmt_maxfmts  // number of formats
+        fmt_default,     // always used for the raw untranslated lump data
+        fmt_patch,       // converted to a patch
+        fmt_maskedpatch, // patch baked into runs for the sprite drawers
+        fmt_maxfmts      // number of formats
     };
 
     void *cache[fmt_maxfmts]; // sf